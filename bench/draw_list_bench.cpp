@@ -0,0 +1,158 @@
+// 绘制列表构建的多线程扩展性测试
+// 剔除、排序键生成、实例打包按段并行，合并后排序，和Scene::render的流程一致
+#include "../engine/core/thread_pool.hpp"
+#include "../engine/renderer/camera.hpp"
+#include "../engine/renderer/draw_list.hpp"
+#include "../engine/renderer/sprite_batch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using engine::render::AABB;
+using engine::render::DrawKey;
+using engine::render::SpriteBatch;
+using engine::render::SpriteSegment;
+using engine::render::TileInfo;
+
+struct Sprite {
+  TileInfo info;
+  SDL_GPUTexture *texture;
+  uint16_t texture_id;
+  uint8_t layer;
+  float depth;
+};
+
+constexpr uint32_t kGrain = 2048;
+constexpr int kFrames = 60;
+
+std::vector<Sprite> makeSprites(uint32_t count) {
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<float> pos{-2000.0f, 2000.0f};
+  std::uniform_int_distribution<uint32_t> texture{1, 32};
+  std::uniform_int_distribution<uint32_t> layer{0, 3};
+  std::vector<Sprite> ret(count);
+  for (auto &sprite : ret) {
+    uint32_t id = texture(rng);
+    sprite.info.pos = {pos(rng), pos(rng)};
+    sprite.info.size = {32.0f, 32.0f};
+    // 只用作区分贴图的键，不会被解引用
+    sprite.texture = reinterpret_cast<SDL_GPUTexture *>(uintptr_t{id} << 4);
+    sprite.texture_id = static_cast<uint16_t>(id);
+    sprite.layer = static_cast<uint8_t>(layer(rng));
+    sprite.depth = sprite.info.pos.y;
+  }
+  return ret;
+}
+
+void buildSegment(const std::vector<Sprite> &sprites, const AABB &view,
+                  uint32_t begin, uint32_t end, SpriteSegment &segment) {
+  segment.clear();
+  for (uint32_t i = begin; i < end; i++) {
+    const auto &sprite = sprites[i];
+    glm::vec2 half = sprite.info.size * 0.5f;
+    AABB bounds{.min = sprite.info.pos - half, .max = sprite.info.pos + half};
+    if (!bounds.intersects(view)) {
+      segment.culled++;
+      continue;
+    }
+    segment.submit(
+        DrawKey::make(sprite.layer, 0, sprite.texture_id, sprite.depth),
+        sprite.texture, sprite.info);
+    segment.visible++;
+  }
+}
+
+struct Result {
+  // 每帧构建时间的中位数(微秒)
+  double time;
+  size_t runs;
+  // 最后一帧绘制段的哈希，用来检查合并结果和单线程一致
+  uint64_t hash;
+};
+
+Result run(const std::vector<Sprite> &sprites, uint32_t threads) {
+  // 调用线程也参与，工作线程数比总线程数少一个
+  std::unique_ptr<engine::core::ThreadPool> pool;
+  if (threads > 1) {
+    pool = std::make_unique<engine::core::ThreadPool>(threads - 1);
+  }
+  std::vector<SpriteSegment> segments(threads);
+  SpriteBatch batch{nullptr};
+  engine::render::Camera camera;
+  camera.setViewport({2560.0f, 1440.0f});
+
+  auto count = static_cast<uint32_t>(sprites.size());
+  std::vector<double> times;
+  Result ret{};
+  for (int frame = 0; frame < kFrames; frame++) {
+    camera.setPosition({static_cast<float>(frame * 10), 0.0f});
+    AABB view = camera.getViewBounds();
+    auto start = std::chrono::steady_clock::now();
+
+    uint32_t used = 1;
+    if (pool) {
+      used = pool->parallelFor(
+          count, kGrain, [&](uint32_t seg, uint32_t begin, uint32_t end) {
+            buildSegment(sprites, view, begin, end, segments[seg]);
+          });
+    } else {
+      buildSegment(sprites, view, 0, count, segments[0]);
+    }
+    for (uint32_t i = 0; i < used; i++) {
+      batch.merge(segments[i]);
+    }
+    batch.build();
+    ret.runs = batch.getRuns().size();
+    ret.hash = 14695981039346656037ull;
+    for (const auto &r : batch.getRuns()) {
+      for (uint64_t v : {uint64_t(uintptr_t(r.texture)), uint64_t{r.first},
+                         uint64_t{r.count}}) {
+        ret.hash = (ret.hash ^ v) * 1099511628211ull;
+      }
+    }
+    batch.clear();
+
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    times.push_back(elapsed.count());
+  }
+  std::sort(times.begin(), times.end());
+  ret.time = times[times.size() / 2];
+  return ret;
+}
+
+} // namespace
+
+int main() {
+  uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<uint32_t> thread_counts;
+  for (uint32_t t = 1; t < max_threads; t *= 2) {
+    thread_counts.push_back(t);
+  }
+  thread_counts.push_back(max_threads);
+
+  for (uint32_t count : {10000u, 100000u}) {
+    auto sprites = makeSprites(count);
+    std::printf("精灵数 %u\n", count);
+    std::printf("%8s %12s %8s %8s\n", "线程", "构建(us)", "加速比", "绘制段");
+    Result base{};
+    for (uint32_t threads : thread_counts) {
+      Result result = run(sprites, threads);
+      if (threads == 1) {
+        base = result;
+      }
+      // 合并顺序固定，绘制段必须和单线程一致
+      std::printf("%8u %12.1f %8.2f %8zu%s\n", threads, result.time,
+                  base.time / result.time, result.runs,
+                  result.hash == base.hash ? "" : " 不一致");
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+// 对象遍历的内存布局测试
+// 比较vector<unique_ptr<Object>>和按原型分块的World，每帧记录插值起点、移动、剔除
+#include "../engine/object/systems.hpp"
+#include "../engine/object/world.hpp"
+#include "../engine/renderer/camera.hpp"
+#include "../engine/renderer/tile.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using engine::render::AABB;
+using engine::render::TileInfo;
+
+constexpr uint32_t kCount = 100000;
+constexpr int kFrames = 60;
+constexpr float kDt = 1.0f / 60.0f;
+
+// 和Tile相同的字段，每个对象单独分配
+struct LegacyTile {
+  void *owner;
+  TileInfo info;
+  glm::vec2 prev;
+  void *resources;
+  engine::resource::TextureHandle texture;
+  uint8_t layer;
+  float depth;
+  engine::render::BlendMode blend;
+  bool init;
+};
+
+// 和Object相同的布局，名字和tile都在堆上
+struct LegacyObject {
+  std::string name;
+  engine::core::StringId id;
+  bool remove;
+  std::unique_ptr<LegacyTile> tile;
+  glm::vec2 velocity;
+};
+
+struct Spawn {
+  glm::vec2 pos;
+  glm::vec2 velocity;
+  bool moving;
+};
+
+std::vector<Spawn> makeSpawns() {
+  std::mt19937 rng{42};
+  std::uniform_real_distribution<float> pos{-4000.0f, 4000.0f};
+  std::uniform_real_distribution<float> vel{-50.0f, 50.0f};
+  std::vector<Spawn> ret(kCount);
+  for (auto &spawn : ret) {
+    spawn.pos = {pos(rng), pos(rng)};
+    spawn.velocity = {vel(rng), vel(rng)};
+    // 一半的对象是静止的，在World中属于另一个原型
+    spawn.moving = rng() % 2 == 0;
+  }
+  return ret;
+}
+
+struct Result {
+  // 每帧耗时的中位数(微秒)
+  double update;
+  double cull;
+  uint32_t visible;
+};
+
+double median(std::vector<double> &times) {
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+template <typename Update, typename Cull>
+Result measure(Update &&update, Cull &&cull) {
+  engine::render::Camera camera;
+  camera.setViewport({2560.0f, 1440.0f});
+  std::vector<double> update_times;
+  std::vector<double> cull_times;
+  Result ret{};
+  for (int frame = 0; frame < kFrames; frame++) {
+    camera.setPosition({static_cast<float>(frame * 10), 0.0f});
+    AABB view = camera.getViewBounds();
+    auto start = std::chrono::steady_clock::now();
+    update();
+    auto mid = std::chrono::steady_clock::now();
+    ret.visible = cull(view);
+    auto end = std::chrono::steady_clock::now();
+    update_times.push_back(
+        std::chrono::duration<double, std::micro>(mid - start).count());
+    cull_times.push_back(
+        std::chrono::duration<double, std::micro>(end - mid).count());
+  }
+  ret.update = median(update_times);
+  ret.cull = median(cull_times);
+  return ret;
+}
+
+Result runLegacy(const std::vector<Spawn> &spawns) {
+  std::vector<std::unique_ptr<LegacyObject>> objs;
+  for (uint32_t i = 0; i < spawns.size(); i++) {
+    auto obj = std::make_unique<LegacyObject>();
+    obj->name = "object " + std::to_string(i);
+    obj->tile = std::make_unique<LegacyTile>();
+    obj->tile->info.pos = spawns[i].pos;
+    obj->tile->info.size = {32.0f, 32.0f};
+    obj->tile->prev = spawns[i].pos;
+    obj->velocity = spawns[i].moving ? spawns[i].velocity : glm::vec2{0.0f};
+    objs.push_back(std::move(obj));
+  }
+  // 运行一段时间后增删过的对象在堆上不再连续
+  std::shuffle(objs.begin(), objs.end(), std::mt19937{7});
+  return measure(
+      [&] {
+        for (auto &obj : objs) {
+          obj->tile->prev = obj->tile->info.pos;
+          obj->tile->info.pos += obj->velocity * kDt;
+        }
+      },
+      [&](const AABB &view) {
+        uint32_t visible = 0;
+        for (const auto &obj : objs) {
+          const LegacyTile &tile = *obj->tile;
+          glm::vec2 half = tile.info.size * 0.5f;
+          AABB bounds{.min = glm::min(tile.prev, tile.info.pos) - half,
+                      .max = glm::max(tile.prev, tile.info.pos) + half};
+          visible += bounds.intersects(view);
+        }
+        return visible;
+      });
+}
+
+Result runWorld(const std::vector<Spawn> &spawns) {
+  using namespace engine::object;
+  World world;
+  for (const auto &spawn : spawns) {
+    Transform transform{.pos = spawn.pos, .prev = spawn.pos};
+    Sprite sprite{};
+    sprite.size = {32.0f, 32.0f};
+    if (spawn.moving) {
+      world.create(transform, sprite, Velocity{spawn.velocity});
+    } else {
+      world.create(transform, sprite);
+    }
+  }
+  return measure(
+      [&] {
+        savePrevious(world);
+        integrate(world, kDt);
+      },
+      [&](const AABB &view) {
+        uint32_t visible = 0;
+        world.forEachChunk<Transform, Sprite>(
+            [&](uint32_t count, const Entity *, Transform *transforms,
+                Sprite *sprites) {
+              for (uint32_t i = 0; i < count; i++) {
+                glm::vec2 half = sprites[i].size * 0.5f;
+                AABB bounds{
+                    .min = glm::min(transforms[i].prev, transforms[i].pos) -
+                           half,
+                    .max = glm::max(transforms[i].prev, transforms[i].pos) +
+                           half};
+                visible += bounds.intersects(view);
+              }
+            });
+        return visible;
+      });
+}
+
+} // namespace
+
+int main() {
+  auto spawns = makeSpawns();
+  Result legacy = runLegacy(spawns);
+  Result world = runWorld(spawns);
+  std::printf("对象数 %u\n", kCount);
+  std::printf("%10s %12s %12s %8s\n", "布局", "更新(us)", "剔除(us)", "可见");
+  std::printf("%10s %12.1f %12.1f %8u\n", "Object", legacy.update, legacy.cull,
+              legacy.visible);
+  std::printf("%10s %12.1f %12.1f %8u%s\n", "World", world.update, world.cull,
+              world.visible, world.visible == legacy.visible ? "" : " 不一致");
+  std::printf("加速比: 更新 %.2f 剔除 %.2f\n", legacy.update / world.update,
+              legacy.cull / world.cull);
+  return 0;
+}
@@ -1,19 +1,25 @@
 #include "app.hpp"
 #include "../input/input.hpp"
 #include "../renderer/renderer.hpp"
+#include "../resource_manager/asset_pack.hpp"
 #include "../resource_manager/resource_manager.hpp"
 #include "../scene/manager.hpp"
 #include "SDL3/SDL.h"
 #include "context.hpp"
+#include "fixed_timestep.hpp"
+#include "profiler.hpp"
 #include "spdlog/spdlog.h"
+#include "thread_pool.hpp"
 #include "time.hpp"
 #include <algorithm>
 #include <exception>
+#include <fstream>
 #include <memory>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace engine::core {
 
@@ -39,38 +45,90 @@ void App::initAppInfo() {
 }
 
 void App::initSDL() {
+  if (m_config.headless_frames > 0) {
+    // 没有显示器时使用offscreen视频驱动，环境变量指定的驱动优先
+    SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+  }
   if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_JOYSTICK)) {
     spdlog::error("SDL初始化失败{}", SDL_GetError());
     throw std::runtime_error("SDL初始化失败");
   }
 }
 
-bool App::init() {
+bool App::init(const AppConfig &config) {
+  m_config = config;
+  m_init_start = SDL_GetTicksNS();
+  bool headless = m_config.headless_frames > 0;
+  TRIAL_PROFILE_THREAD("main");
   try {
     initAppInfo();
     initSDL();
 
+    // 后台任务线程，渲染器初始化时用来并行创建管线
+    m_thread_pool = std::make_unique<ThreadPool>();
+    if (!m_config.pack_path.empty()) {
+      m_asset_pack = engine::resource::AssetPack::open(m_config.pack_path);
+      if (!m_asset_pack) {
+        return false;
+      }
+    }
     // 初始化渲染器
     m_render = std::make_unique<engine::render::Renderer>();
-    if (!m_render->init()) {
+    engine::render::RendererConfig render_config{
+        .width = 1024,
+        .height = 720,
+        .headless = headless,
+        .pack = m_asset_pack.get(),
+    };
+    if (!m_render->init(m_thread_pool.get(), render_config)) {
       return false;
     }
-    // 初始化时间管理器
-    m_time = std::make_unique<Time>(144);
+    // 初始化时间管理器，无窗口模式不限帧
+    m_time = std::make_unique<Time>(headless ? 0 : 144);
+    if (m_config.align_refresh) {
+      m_time->alignToRefreshRate(m_render->getRefreshRate());
+    }
     m_time->init();
+    m_fixed_step = std::make_unique<FixedTimestep>(m_config.tick_rate,
+                                                   m_config.max_ticks);
     // 初始化输入管理
     m_input_manager = std::make_unique<engine::input::Manager>();
+    if (!m_config.bindings_path.empty() &&
+        !m_input_manager->loadBindings(m_config.bindings_path)) {
+      spdlog::warn("使用默认按键绑定");
+    }
+    if (!m_config.replay_path.empty()) {
+      if (!m_input_manager->startReplay(m_config.replay_path,
+                                        m_config.tick_rate)) {
+        throw std::runtime_error("打开回放文件失败");
+      }
+    } else if (!m_config.record_path.empty() &&
+               !m_input_manager->startRecording(m_config.record_path,
+                                                m_config.tick_rate)) {
+      throw std::runtime_error("打开录制文件失败");
+    }
     // 初始化资源管理器
     m_resource_manager = std::make_unique<engine::resource::Manager>();
-    m_resource_manager->init(*m_render);
+    m_resource_manager->init(*m_render, *m_thread_pool, m_asset_pack.get());
+    m_resource_manager->textureSetBudget(uint64_t{m_config.texture_budget_mb}
+                                         << 20);
 
     m_context = std::make_unique<Context>(*m_render, *m_input_manager,
-                                          *m_resource_manager);
+                                          *m_resource_manager, *m_thread_pool);
     m_scene_manager = std::make_unique<engine::scene::Manager>(*m_context);
+    if (m_config.profile_frames > 0) {
+#ifdef TRIAL_PROFILE
+      Profiler::get().beginCapture(m_config.profile_frames,
+                                   m_config.profile_path);
+#else
+      spdlog::warn("没有编译性能分析，需要打开TRIAL_PROFILE重新编译");
+#endif
+    }
   } catch (const std::exception &e) {
     spdlog::error("app初始化失败{}", e.what());
     return false;
   }
+  spdlog::info("初始化耗时{:.3f}ms", (SDL_GetTicksNS() - m_init_start) / 1e6);
   return true;
 }
 
@@ -78,35 +136,176 @@ void App::deinit() {
   // 先销毁渲染器，再退出SDL
   m_scene_manager.reset();
   m_resource_manager.reset();
+  // 工作线程可能还在解码，渲染器和SDL退出前结束
+  m_thread_pool.reset();
   m_input_manager.reset();
   m_render.reset();
+  m_asset_pack.reset();
+  if (!m_config.timings_path.empty()) {
+    saveTimings();
+  }
+  if (m_config.headless_frames > 0 && m_frame_count > 0) {
+    spdlog::info("无窗口渲染{}帧，平均{:.3f}ms，最长{:.3f}ms", m_frame_count,
+                 m_frame_time_total / 1e6 / m_frame_count,
+                 m_frame_time_max / 1e6);
+  }
   m_time->deinit();
   SDL_Quit();
 }
 
 bool App::render() {
+  TRIAL_PROFILE_ZONE("App::render");
+  // 后台加载完成的贴图写入上传环，随本帧的copy pass一起上传
+  m_resource_manager->textureProcessLoaded();
+  bool headless = m_config.headless_frames > 0;
+  // 最后一帧回读
+  bool capture = headless && !m_config.capture_path.empty() &&
+                 m_frame_count + 1 == m_config.headless_frames;
+  if (capture) {
+    m_render->captureFrame();
+  }
   if (m_render->begin()) {
 
     m_scene_manager->render();
     m_render->end();
   }
+  TRIAL_PROFILE_FRAME();
+  if (m_first_frame) {
+    m_first_frame = false;
+    spdlog::info("启动到第一帧耗时{:.3f}ms，资源包{}",
+                 (SDL_GetTicksNS() - m_init_start) / 1e6,
+                 m_asset_pack ? m_config.pack_path : "未使用");
+  }
+  uint64_t elapsed = SDL_GetTicksNS() - m_frame_start;
+  if (!m_config.timings_path.empty()) {
+    m_timing.frame_ns = elapsed;
+    m_timings.push_back(m_timing);
+  }
+  if (headless) {
+    m_frame_time_total += elapsed;
+    m_frame_time_max = std::max(m_frame_time_max, elapsed);
+    m_frame_count++;
+    if (capture) {
+      saveCapture();
+    }
+  }
+  // 每秒输出一次渲染统计
+  m_stats_timer += m_time->getDeltaTime();
+  if (m_stats_timer >= 1.0f) {
+    m_stats_timer = 0.0f;
+    const auto &stats = m_render->getStats();
+    spdlog::debug("渲染统计: 可见{} 剔除{} 绘制调用{} 精灵{} 管线绑定{} "
+                  "贴图绑定{} buffer绑定{} uniform{}字节 跳过{} 排序{}us "
+                  "上传{}字节 上传等待{}",
+                  stats.visible, stats.culled, stats.draw_calls,
+                  stats.sprites, stats.pipeline_binds,
+                  stats.texture_binds, stats.buffer_binds,
+                  stats.uniform_bytes, stats.skipped_calls,
+                  stats.sort_time_ns / 1000, stats.upload_bytes,
+                  stats.upload_stalls);
+    const auto &streaming = m_resource_manager->textureStreamingStats();
+    if (streaming.budget > 0) {
+      spdlog::debug("贴图驻留: {}个 {}/{}KB 驱逐{} 重新加载{}{}",
+                    streaming.resident_textures,
+                    streaming.resident_bytes >> 10, streaming.budget >> 10,
+                    streaming.evictions, streaming.reloads,
+                    streaming.over_budget ? " 超出预算" : "");
+    }
+    const auto &tiles = m_render->getTilePoolStats();
+    if (const auto *scene = m_scene_manager->top()) {
+      const auto &objs = scene->getObjPoolStats();
+      spdlog::debug("对象池: 场景{} 存活{} 峰值{} 块{} tile存活{} 峰值{} 块{}",
+                    scene->getName(), objs.live, objs.peak, objs.chunks,
+                    tiles.live, tiles.peak, tiles.chunks);
+    }
+    auto pacing = m_time->getPacingStats();
+    if (pacing.frames > 0) {
+      spdlog::debug("帧间隔偏差: 平均{:.3f}ms p99 {:.3f}ms 睡眠超时{:.3f}ms",
+                    pacing.mean_ms, pacing.p99_ms, pacing.overshoot_ms);
+    }
+  }
   return true;
 }
 
 bool App::update() {
+  TRIAL_PROFILE_ZONE("App::update");
   m_time->update();
-  float dt = m_time->getDeltaTime();
-  m_scene_manager->update(dt);
+  m_frame_start = SDL_GetTicksNS();
+  // 无窗口模式每帧正好一个tick，保证每次运行的结果一致
+  double dt = m_config.headless_frames > 0 ? m_fixed_step->getStep()
+                                           : m_time->getDeltaTime();
+  // 上一帧之后的事件统一处理，场景每帧只收到一次事件回调
+  // 回放时事件和dt都来自录制的文件
+  dt = m_input_manager->beginFrame(dt);
+  if (m_input_manager->isReplaying()) {
+    m_time->setDeltaTime(dt);
+  }
+  m_scene_manager->event();
+  uint32_t ticks = m_fixed_step->advance(dt);
+  auto step = static_cast<float>(m_fixed_step->getStep());
+  for (uint32_t i = 0; i < ticks; i++) {
+    m_scene_manager->update(step);
+  }
+  m_render->setInterpolation(m_fixed_step->getAlpha());
+  m_timing.dt = dt;
+  m_timing.ticks = ticks;
+  m_timing.update_ns = SDL_GetTicksNS() - m_frame_start;
   return true;
 }
 
 bool App::event(const SDL_Event *event [[maybe_unused]]) {
+  TRIAL_PROFILE_ZONE("App::event");
+  // 只放进输入队列，下一帧开始时处理
   m_input_manager->update(*event);
-  if (m_input_manager->shouldQuit()) {
-    return false;
+  return !m_input_manager->shouldQuit();
+}
+
+bool App::finished() const {
+  if (m_input_manager->replayFinished()) {
+    return true;
   }
-  m_scene_manager->event();
-  return true;
+  return m_config.headless_frames > 0 &&
+         m_frame_count >= m_config.headless_frames;
+}
+
+void App::saveTimings() {
+  std::ofstream out{m_config.timings_path};
+  if (!out) {
+    spdlog::error("写入帧耗时{}失败", m_config.timings_path);
+    return;
+  }
+  out << "frame,dt_ms,ticks,update_ms,frame_ms\n";
+  for (size_t i = 0; i < m_timings.size(); i++) {
+    const auto &timing = m_timings[i];
+    out << fmt::format("{},{:.4f},{},{:.4f},{:.4f}\n", i, timing.dt * 1e3,
+                       timing.ticks, timing.update_ns / 1e6,
+                       timing.frame_ns / 1e6);
+  }
+  spdlog::info("保存{}帧的耗时到{}", m_timings.size(), m_config.timings_path);
+}
+
+void App::saveCapture() {
+  std::vector<uint8_t> pixels;
+  if (!m_render->readPixels(pixels)) {
+    spdlog::error("回读最后一帧失败");
+    return;
+  }
+  auto size = m_render->getWindowSize();
+  auto w = static_cast<int>(size.x);
+  auto h = static_cast<int>(size.y);
+  // 离屏贴图是R8G8B8A8，对应SDL的ABGR8888
+  SDL_Surface *surface = SDL_CreateSurfaceFrom(
+      w, h, SDL_PIXELFORMAT_ABGR8888, pixels.data(), w * 4);
+  if (!surface) {
+    spdlog::error("创建截图surface失败{}", SDL_GetError());
+    return;
+  }
+  if (!SDL_SaveBMP(surface, m_config.capture_path.c_str())) {
+    spdlog::error("保存截图{}失败{}", m_config.capture_path, SDL_GetError());
+  } else {
+    spdlog::info("最后一帧保存到{}", m_config.capture_path);
+  }
+  SDL_DestroySurface(surface);
 }
 
 void App::pushScene(std::unique_ptr<engine::scene::Scene> &&scene) {
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "SDL3/SDL_events.h"
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace engine::render {
 class Renderer;
@@ -18,12 +21,42 @@ class Manager;
 
 namespace engine::resource {
 class Manager;
+class AssetPack;
 }
 
 namespace engine::core {
 
 class Time;
+class FixedTimestep;
 class Context;
+class ThreadPool;
+
+struct AppConfig {
+  // 大于0时不创建窗口，渲染到离屏贴图，跑完指定帧数后退出
+  uint32_t headless_frames{0};
+  // 无窗口模式下最后一帧保存为bmp，空表示不保存
+  std::string capture_path;
+  // 大于0时从第一帧开始记录性能区间，需要TRIAL_PROFILE编译
+  uint32_t profile_frames{0};
+  std::string profile_path{"trace.json"};
+  // 帧率对齐到显示器刷新率
+  bool align_refresh{true};
+  // 场景更新的固定频率，和每帧最多执行的tick数
+  uint32_t tick_rate{60};
+  uint32_t max_ticks{5};
+  // asset_cooker生成的资源包，空表示直接加载散文件
+  std::string pack_path;
+  // 贴图显存预算，超出时驱逐最近没有绘制的贴图，0表示不限制
+  uint32_t texture_budget_mb{0};
+  // 按键绑定文件，加载失败时使用默认绑定
+  std::string bindings_path{"../asset/input.json"};
+  // 录制每帧的输入和dt，回放录制的文件，两者不能同时使用
+  // 回放时忽略实时输入，回放结束后退出，配合headless_frames可以不创建窗口
+  std::string record_path;
+  std::string replay_path;
+  // 每帧的cpu耗时写成csv，用于逐帧比较两次编译的结果
+  std::string timings_path;
+};
 
 /*
  * app累需要手动进行初始化和退出
@@ -31,25 +64,52 @@ class Context;
 class App final {
 private:
   std::unique_ptr<Time> m_time;
+  std::unique_ptr<FixedTimestep> m_fixed_step;
+  std::unique_ptr<ThreadPool> m_thread_pool;
+  // 比渲染器和资源管理器活得久，音乐和字体会持续读取映射的内存
+  std::unique_ptr<engine::resource::AssetPack> m_asset_pack;
   std::unique_ptr<engine::render::Renderer> m_render;
   std::unique_ptr<engine::input::Manager> m_input_manager;
   std::unique_ptr<engine::resource::Manager> m_resource_manager;
   std::unique_ptr<Context> m_context;
   std::unique_ptr<engine::scene::Manager> m_scene_manager;
+  float m_stats_timer{0.0f};
+  AppConfig m_config;
+  // 无窗口模式的帧计数和每帧cpu耗时
+  uint32_t m_frame_count{0};
+  uint64_t m_frame_start{0};
+  uint64_t m_frame_time_total{0};
+  uint64_t m_frame_time_max{0};
+  // 每帧的cpu耗时，设置了timings_path时记录
+  struct FrameTiming {
+    double dt;
+    uint32_t ticks;
+    uint64_t update_ns;
+    uint64_t frame_ns;
+  };
+  std::vector<FrameTiming> m_timings;
+  FrameTiming m_timing{};
+  // 从init开始到第一帧结束，用于比较有无资源包时的启动时间
+  uint64_t m_init_start{0};
+  bool m_first_frame{true};
 
 private:
   void initAppInfo();
   void initSDL();
+  void saveCapture();
+  void saveTimings();
 
 public:
   App();
   ~App();
 
-  [[nodiscard]] bool init();
+  [[nodiscard]] bool init(const AppConfig &config = {});
   void deinit();
   bool render();
   bool update();
   bool event(const SDL_Event *);
+  // 无窗口模式跑完了指定帧数
+  bool finished() const;
 
   void pushScene(std::unique_ptr<engine::scene::Scene> &&);
 
@@ -13,23 +13,28 @@ class Manager;
 }
 
 namespace engine::core {
+class ThreadPool;
+
 class Context {
 private:
   engine::render::Renderer &m_renderer;
   engine::input::Manager &m_input_manager;
   engine::resource::Manager &m_resource_manager;
+  ThreadPool &m_thread_pool;
 
 public:
   Context(engine::render::Renderer &renderer,
           engine::input::Manager &input_manager,
-          engine::resource::Manager &resource_manager)
+          engine::resource::Manager &resource_manager,
+          ThreadPool &thread_pool)
       : m_renderer(renderer), m_input_manager(input_manager),
-        m_resource_manager(resource_manager) {}
+        m_resource_manager(resource_manager), m_thread_pool(thread_pool) {}
   ~Context() = default;
 
   engine::render::Renderer &getRenderer() { return m_renderer; }
   engine::input::Manager &getInput() { return m_input_manager; }
   engine::resource::Manager &getResource() { return m_resource_manager; }
+  ThreadPool &getThreadPool() { return m_thread_pool; }
 
   Context(Context &) = delete;
   Context(Context &&) = delete;
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace engine::core {
+
+/*
+ * 固定步长累加器
+ * 每帧累加帧时间，按固定步长取出需要执行的tick数，剩余部分作为插值系数
+ * 一帧最多执行m_max_steps个tick，超出的时间直接丢弃，避免慢帧越积越多
+ */
+class FixedTimestep final {
+private:
+  double m_step{1.0 / 60.0};
+  double m_accumulator{0.0};
+  uint32_t m_max_steps{5};
+  float m_alpha{0.0f};
+  // 因超过每帧最大tick数而丢弃的tick
+  uint64_t m_dropped{0};
+
+public:
+  FixedTimestep(uint32_t tick_rate = 60, uint32_t max_steps = 5) {
+    setTickRate(tick_rate);
+    setMaxSteps(max_steps);
+  }
+  ~FixedTimestep() = default;
+
+  void setTickRate(uint32_t tick_rate) {
+    m_step = 1.0 / std::max(tick_rate, 1u);
+  }
+  void setMaxSteps(uint32_t max_steps) {
+    m_max_steps = std::max(max_steps, 1u);
+  }
+
+  // 累加帧时间，返回本帧要执行的tick数
+  uint32_t advance(double dt) {
+    m_accumulator += std::max(dt, 0.0);
+    auto steps = static_cast<uint64_t>(m_accumulator / m_step);
+    if (steps > m_max_steps) {
+      m_dropped += steps - m_max_steps;
+      steps = m_max_steps;
+      m_accumulator -= steps * m_step;
+      // 只保留不足一个tick的部分
+      m_accumulator -= static_cast<uint64_t>(m_accumulator / m_step) * m_step;
+    } else {
+      m_accumulator -= steps * m_step;
+    }
+    m_alpha = static_cast<float>(m_accumulator / m_step);
+    return static_cast<uint32_t>(steps);
+  }
+
+  double getStep() const { return m_step; }
+  // 上一个tick到下一个tick之间的插值系数，[0, 1)
+  float getAlpha() const { return m_alpha; }
+  uint64_t getDropped() const { return m_dropped; }
+
+  FixedTimestep(FixedTimestep &) = delete;
+  FixedTimestep(FixedTimestep &&) = delete;
+  FixedTimestep &operator=(FixedTimestep &) = delete;
+  FixedTimestep &operator=(FixedTimestep &&) = delete;
+};
+
+} // namespace engine::core
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace engine::core {
+
+/*
+ * 多生产者单消费者的无锁队列
+ * 生产者用CAS压栈，消费者一次取走全部节点后按入队顺序处理
+ */
+template <typename T> class MpscQueue final {
+private:
+  struct Node {
+    T value;
+    Node *next{nullptr};
+  };
+  std::atomic<Node *> m_head{nullptr};
+
+public:
+  MpscQueue() = default;
+  ~MpscQueue() {
+    Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+    while (node) {
+      Node *next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  // 任意线程调用
+  void push(T value) {
+    Node *node = new Node{.value = std::move(value)};
+    node->next = m_head.load(std::memory_order_relaxed);
+    while (!m_head.compare_exchange_weak(node->next, node,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+    }
+  }
+
+  // 只能由消费者线程调用，返回处理的数量
+  template <typename F> size_t drain(F &&func) {
+    Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+    // 栈是后进先出，反转成入队顺序
+    Node *ordered = nullptr;
+    while (node) {
+      Node *next = node->next;
+      node->next = ordered;
+      ordered = node;
+      node = next;
+    }
+    size_t count = 0;
+    while (ordered) {
+      Node *next = ordered->next;
+      func(std::move(ordered->value));
+      delete ordered;
+      ordered = next;
+      count++;
+    }
+    return count;
+  }
+
+  bool empty() const {
+    return m_head.load(std::memory_order_relaxed) == nullptr;
+  }
+
+  MpscQueue(MpscQueue &) = delete;
+  MpscQueue(MpscQueue &&) = delete;
+  MpscQueue &operator=(MpscQueue &) = delete;
+  MpscQueue &operator=(MpscQueue &&) = delete;
+};
+
+} // namespace engine::core
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace engine::core {
+
+struct PoolStats {
+  uint32_t live{0};
+  uint32_t peak{0};
+  uint32_t chunks{0};
+  // 累计分配次数
+  uint64_t allocations{0};
+};
+
+template <typename T> class Pool;
+
+/*
+ * 池分配对象的删除器，pool为空时用delete释放
+ * 可以从默认删除器转换，std::make_unique创建的对象也能放进同一个容器
+ */
+template <typename T> struct PoolDelete {
+  Pool<T> *pool{nullptr};
+
+  PoolDelete() = default;
+  PoolDelete(Pool<T> *p) : pool{p} {}
+  template <typename U>
+    requires std::is_convertible_v<U *, T *>
+  PoolDelete(const std::default_delete<U> &) {}
+
+  void operator()(T *ptr) const {
+    if (pool) {
+      pool->destroy(ptr);
+    } else {
+      delete ptr;
+    }
+  }
+};
+
+template <typename T> using PoolPtr = std::unique_ptr<T, PoolDelete<T>>;
+
+/*
+ * 固定大小块的对象池，空闲块串成链表，用完时按块数整批增长
+ * 频繁创建和销毁的小对象不经过通用堆，内存也更集中
+ * 不是线程安全的，只在主线程使用，池必须比分配出的对象活得久
+ */
+template <typename T> class Pool final {
+private:
+  union Block {
+    Block *next;
+    alignas(T) std::byte storage[sizeof(T)];
+  };
+
+  uint32_t m_chunk_blocks;
+  std::vector<std::unique_ptr<Block[]>> m_chunks;
+  Block *m_free{nullptr};
+  PoolStats m_stats;
+
+private:
+  void grow() {
+    auto chunk = std::make_unique<Block[]>(m_chunk_blocks);
+    for (uint32_t i = 0; i < m_chunk_blocks; i++) {
+      chunk[i].next = i + 1 < m_chunk_blocks ? &chunk[i + 1] : m_free;
+    }
+    m_free = &chunk[0];
+    m_chunks.push_back(std::move(chunk));
+    m_stats.chunks++;
+  }
+
+public:
+  explicit Pool(uint32_t chunk_blocks = 256)
+      : m_chunk_blocks{std::max(chunk_blocks, 1u)} {}
+  ~Pool() {
+    if (m_stats.live > 0) {
+      spdlog::error("对象池销毁时还有{}个对象", m_stats.live);
+    }
+  }
+
+  template <typename... Args> PoolPtr<T> make(Args &&...args) {
+    if (!m_free) {
+      grow();
+    }
+    Block *block = m_free;
+    m_free = block->next;
+    T *ptr = nullptr;
+    try {
+      ptr = ::new (block->storage) T(std::forward<Args>(args)...);
+    } catch (...) {
+      block->next = m_free;
+      m_free = block;
+      throw;
+    }
+    m_stats.live++;
+    m_stats.peak = std::max(m_stats.peak, m_stats.live);
+    m_stats.allocations++;
+    return PoolPtr<T>{ptr, PoolDelete<T>{this}};
+  }
+
+  void destroy(T *ptr) {
+    ptr->~T();
+    auto *block = reinterpret_cast<Block *>(ptr);
+    block->next = m_free;
+    m_free = block;
+    m_stats.live--;
+  }
+
+  const PoolStats &getStats() const { return m_stats; }
+
+  Pool(Pool &) = delete;
+  Pool(Pool &&) = delete;
+  Pool &operator=(Pool &) = delete;
+  Pool &operator=(Pool &&) = delete;
+};
+
+} // namespace engine::core
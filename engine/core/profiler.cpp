@@ -0,0 +1,130 @@
+#include "profiler.hpp"
+#include "nlohmann/json.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace engine::core {
+
+Profiler &Profiler::get() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::ThreadBuffer &Profiler::threadBuffer() {
+  thread_local ThreadBuffer *buffer = nullptr;
+  if (!buffer) {
+    auto ret = std::make_unique<ThreadBuffer>();
+    ret->events = std::make_unique<ProfileEvent[]>(kBufferCapacity);
+    std::lock_guard lock{m_mutex};
+    ret->tid = static_cast<uint32_t>(m_buffers.size());
+    ret->name = "thread " + std::to_string(ret->tid);
+    buffer = ret.get();
+    m_buffers.push_back(std::move(ret));
+  }
+  return *buffer;
+}
+
+void Profiler::setThreadName(std::string_view name) {
+  auto &buffer = threadBuffer();
+  std::lock_guard lock{m_mutex};
+  buffer.name = name;
+}
+
+void Profiler::record(const char *name, uint64_t start, uint64_t end) {
+  auto &buffer = threadBuffer();
+  uint32_t capture = m_capture_id.load(std::memory_order_acquire);
+  // 上一次捕获留下的内容作废
+  if (buffer.capture.load(std::memory_order_relaxed) != capture) {
+    buffer.count.store(0, std::memory_order_relaxed);
+    buffer.dropped.store(0, std::memory_order_relaxed);
+    buffer.capture.store(capture, std::memory_order_release);
+  }
+  uint32_t count = buffer.count.load(std::memory_order_relaxed);
+  if (count >= kBufferCapacity) {
+    buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer.events[count] = ProfileEvent{.name = name, .start = start, .end = end};
+  buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::beginCapture(uint32_t frames, std::string path) {
+  if (frames == 0 || s_active.load(std::memory_order_relaxed)) {
+    return;
+  }
+  m_pending_frames = frames;
+  m_path = std::move(path);
+}
+
+void Profiler::frame() {
+  uint64_t now = SDL_GetTicksNS();
+  if (s_active.load(std::memory_order_relaxed)) {
+    record("frame", m_frame_start, now);
+    if (--m_frames_left == 0) {
+      s_active.store(false, std::memory_order_relaxed);
+      exportTrace();
+    }
+  } else if (m_pending_frames > 0) {
+    m_frames_left = std::exchange(m_pending_frames, 0);
+    m_capture_id.fetch_add(1, std::memory_order_release);
+    m_capture_start = now;
+    s_active.store(true, std::memory_order_relaxed);
+    spdlog::info("开始记录性能区间，{}帧", m_frames_left);
+  }
+  m_frame_start = SDL_GetTicksNS();
+}
+
+bool Profiler::exportTrace() {
+  uint32_t capture = m_capture_id.load(std::memory_order_relaxed);
+  // 工作线程可能还在追加区间，只导出已经发布的部分
+  auto us = [this](uint64_t ns) {
+    return static_cast<double>(ns - std::min(ns, m_capture_start)) / 1000.0;
+  };
+  nlohmann::json events = nlohmann::json::array();
+  size_t total = 0;
+  uint32_t dropped = 0;
+  {
+    std::lock_guard lock{m_mutex};
+    for (const auto &buffer : m_buffers) {
+      events.push_back({{"name", "thread_name"},
+                        {"ph", "M"},
+                        {"pid", 1},
+                        {"tid", buffer->tid},
+                        {"args", {{"name", buffer->name}}}});
+      if (buffer->capture.load(std::memory_order_acquire) != capture) {
+        continue;
+      }
+      uint32_t count = buffer->count.load(std::memory_order_acquire);
+      for (uint32_t i = 0; i < count; i++) {
+        const auto &event = buffer->events[i];
+        events.push_back({{"name", event.name},
+                          {"ph", "X"},
+                          {"pid", 1},
+                          {"tid", buffer->tid},
+                          {"ts", us(event.start)},
+                          {"dur", static_cast<double>(event.end - event.start) /
+                                      1000.0}});
+      }
+      total += count;
+      dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::ofstream out{m_path};
+  if (!out) {
+    spdlog::error("打开性能记录文件{}失败", m_path);
+    return false;
+  }
+  nlohmann::json trace{{"traceEvents", std::move(events)},
+                       {"displayTimeUnit", "ms"}};
+  out << trace.dump();
+  if (dropped > 0) {
+    spdlog::warn("性能记录缓冲区已满，丢弃{}个区间", dropped);
+  }
+  spdlog::info("性能记录写入{}，{}个区间", m_path, total);
+  return true;
+}
+
+} // namespace engine::core
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "SDL3/SDL_timer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace engine::core {
+
+// 一个区间，时间戳来自SDL_GetTicksNS
+struct ProfileEvent {
+  // 只保存指针，必须是字符串字面量之类的静态字符串
+  const char *name;
+  uint64_t start;
+  uint64_t end;
+};
+
+/*
+ * 区间性能分析器
+ * 每个线程第一次记录时注册自己的缓冲区，之后只由该线程写入，不加锁
+ * beginCapture之后的指定帧数内记录区间，结束时导出chrome trace_event json
+ * 编译时没有定义TRIAL_PROFILE时，下面的宏全部展开为空
+ */
+class Profiler final {
+public:
+  // 每个线程每次捕获最多记录的区间数，超出的丢弃
+  static constexpr uint32_t kBufferCapacity = 1u << 16;
+
+private:
+  struct ThreadBuffer {
+    std::unique_ptr<ProfileEvent[]> events;
+    // 已写入的区间数，写入线程release，导出时acquire
+    std::atomic<uint32_t> count{0};
+    // 缓冲区内容所属的捕获编号，由写入线程在新捕获开始后重置
+    std::atomic<uint32_t> capture{0};
+    std::atomic<uint32_t> dropped{0};
+    uint32_t tid{0};
+    std::string name;
+  };
+
+  static inline std::atomic<bool> s_active{false};
+
+  std::atomic<uint32_t> m_capture_id{0};
+  // 只在注册线程和导出时加锁
+  std::mutex m_mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+  // 以下只在主线程访问
+  uint32_t m_pending_frames{0};
+  uint32_t m_frames_left{0};
+  uint64_t m_capture_start{0};
+  uint64_t m_frame_start{0};
+  std::string m_path;
+
+private:
+  Profiler() = default;
+  ThreadBuffer &threadBuffer();
+  bool exportTrace();
+
+public:
+  ~Profiler() = default;
+
+  static Profiler &get();
+  static bool active() { return s_active.load(std::memory_order_relaxed); }
+
+  // 在trace中显示的线程名
+  void setThreadName(std::string_view name);
+  void record(const char *name, uint64_t start, uint64_t end);
+
+  // 从下一帧开始记录frames帧，结束后写入path
+  void beginCapture(uint32_t frames, std::string path);
+  // 主线程每帧结束时调用，同时记录整帧区间
+  void frame();
+
+  Profiler(Profiler &) = delete;
+  Profiler(Profiler &&) = delete;
+  Profiler &operator=(Profiler &) = delete;
+  Profiler &operator=(Profiler &&) = delete;
+};
+
+// 构造到析构之间记录为一个区间，没有在捕获时几乎没有开销
+class ProfileZone final {
+private:
+  const char *m_name;
+  uint64_t m_start;
+
+public:
+  explicit ProfileZone(const char *name)
+      : m_name{Profiler::active() ? name : nullptr},
+        m_start{m_name ? SDL_GetTicksNS() : 0} {}
+  ~ProfileZone() {
+    if (m_name) {
+      Profiler::get().record(m_name, m_start, SDL_GetTicksNS());
+    }
+  }
+
+  ProfileZone(ProfileZone &) = delete;
+  ProfileZone(ProfileZone &&) = delete;
+  ProfileZone &operator=(ProfileZone &) = delete;
+  ProfileZone &operator=(ProfileZone &&) = delete;
+};
+
+} // namespace engine::core
+
+#ifdef TRIAL_PROFILE
+#define TRIAL_PROFILE_CONCAT_(a, b) a##b
+#define TRIAL_PROFILE_CONCAT(a, b) TRIAL_PROFILE_CONCAT_(a, b)
+#define TRIAL_PROFILE_ZONE(name)                                               \
+  ::engine::core::ProfileZone TRIAL_PROFILE_CONCAT(trial_profile_zone_,        \
+                                                   __LINE__) {                 \
+    name                                                                       \
+  }
+#define TRIAL_PROFILE_THREAD(name)                                             \
+  ::engine::core::Profiler::get().setThreadName(name)
+#define TRIAL_PROFILE_FRAME() ::engine::core::Profiler::get().frame()
+#else
+#define TRIAL_PROFILE_ZONE(name) ((void)0)
+#define TRIAL_PROFILE_THREAD(name) ((void)0)
+#define TRIAL_PROFILE_FRAME() ((void)0)
+#endif
@@ -0,0 +1,48 @@
+#include "string_id.hpp"
+#include "spdlog/spdlog.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace engine::core {
+
+#ifndef NDEBUG
+namespace {
+// 调试版的反查表，资源可能在工作线程加载，需要加锁
+struct ReverseTable {
+  std::mutex mutex;
+  std::unordered_map<uint64_t, std::string> names;
+};
+
+ReverseTable &reverseTable() {
+  static ReverseTable table;
+  return table;
+}
+} // namespace
+#endif
+
+StringId StringId::intern(std::string_view str) {
+  StringId id{fnv1a(str)};
+#ifndef NDEBUG
+  auto &table = reverseTable();
+  std::lock_guard lock{table.mutex};
+  auto [it, inserted] = table.names.try_emplace(id.m_hash, str);
+  if (!inserted && it->second != str) {
+    spdlog::error("字符串哈希冲突: \"{}\"和\"{}\"", it->second, str);
+  }
+#endif
+  return id;
+}
+
+std::string StringId::str() const {
+#ifndef NDEBUG
+  auto &table = reverseTable();
+  std::lock_guard lock{table.mutex};
+  if (auto it = table.names.find(m_hash); it != table.names.end()) {
+    return it->second;
+  }
+#endif
+  return fmt::format("#{:016x}", m_hash);
+}
+
+} // namespace engine::core
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace engine::core {
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+constexpr uint64_t fnv1a(std::string_view str) {
+  uint64_t hash = kFnvOffset;
+  for (char c : str) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+/*
+ * 字符串的64位FNV-1a哈希，比较和查找只比较整数
+ * 字面量在编译期计算: isActionPress("attack")、"attack"_sid
+ * 运行时的字符串通过intern()转换，调试版会登记到反查表，用于日志和检测冲突
+ */
+class StringId final {
+private:
+  uint64_t m_hash{0};
+
+  constexpr explicit StringId(uint64_t hash) : m_hash{hash} {}
+
+public:
+  constexpr StringId() = default;
+  // 只接受编译期常量，运行时的字符串需要用intern()
+  consteval StringId(const char *str)
+      : m_hash{fnv1a(std::string_view{str})} {}
+
+  static constexpr StringId fromHash(uint64_t hash) { return StringId{hash}; }
+  static StringId intern(std::string_view str);
+
+  constexpr uint64_t value() const { return m_hash; }
+  constexpr bool valid() const { return m_hash != 0; }
+  constexpr auto operator<=>(const StringId &) const = default;
+
+  // 调试版返回登记过的原字符串，其他情况返回哈希的十六进制
+  std::string str() const;
+};
+
+namespace literals {
+consteval StringId operator""_sid(const char *str, size_t len) {
+  return StringId::fromHash(fnv1a(std::string_view{str, len}));
+}
+} // namespace literals
+
+// 哈希已经足够分散，直接作为桶下标
+struct StringIdHash {
+  size_t operator()(StringId id) const {
+    return static_cast<size_t>(id.value());
+  }
+};
+
+} // namespace engine::core
+
+template <> struct std::hash<engine::core::StringId> {
+  size_t operator()(engine::core::StringId id) const {
+    return engine::core::StringIdHash{}(id);
+  }
+};
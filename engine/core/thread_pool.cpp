@@ -0,0 +1,64 @@
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <utility>
+
+namespace engine::core {
+
+ThreadPool::ThreadPool(uint32_t count) {
+  if (count == 0) {
+    count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+  }
+  m_workers.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    m_workers.emplace_back([this] { work(); });
+  }
+  spdlog::trace("线程池初始化，线程数{}", count);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lock{m_mutex};
+    m_stop = true;
+    m_jobs.clear();
+  }
+  m_cv.notify_all();
+  m_workers.clear();
+  spdlog::trace("线程池退出");
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+  {
+    std::lock_guard lock{m_mutex};
+    m_jobs.push_back(std::move(job));
+  }
+  m_cv.notify_one();
+}
+
+void ThreadPool::submitUrgent(std::function<void()> job) {
+  {
+    std::lock_guard lock{m_mutex};
+    m_jobs.push_front(std::move(job));
+  }
+  m_cv.notify_one();
+}
+
+void ThreadPool::work() {
+  TRIAL_PROFILE_THREAD("worker");
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock lock{m_mutex};
+      m_cv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+      if (m_stop) {
+        return;
+      }
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    job();
+  }
+}
+
+} // namespace engine::core
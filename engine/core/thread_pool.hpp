@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine::core {
+
+/*
+ * 固定数量的工作线程，处理加载之类的后台任务
+ */
+class ThreadPool final {
+private:
+  std::vector<std::jthread> m_workers;
+  std::deque<std::function<void()>> m_jobs;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_stop{false};
+
+private:
+  void work();
+
+public:
+  // count为0时按cpu核数减一
+  ThreadPool(uint32_t count = 0);
+  // 丢弃还没开始的任务，等待正在执行的任务结束
+  ~ThreadPool();
+
+  void submit(std::function<void()> job);
+  // 放在队首，用于当前帧要等待结果的任务，不排在贴图解码之类的后台任务后面
+  void submitUrgent(std::function<void()> job);
+
+  /*
+   * 把[0, count)切成最多size() + 1个连续的段并行执行
+   * func(segment, begin, end)，段号从小到大覆盖整个范围，返回段数
+   * 调用线程和工作线程从同一个计数器领取段，工作线程忙时调用线程自己处理
+   * 会阻塞等待所有段完成，不能在工作线程中调用
+   */
+  template <typename F>
+  uint32_t parallelFor(uint32_t count, uint32_t min_grain, F &&func) {
+    min_grain = std::max(min_grain, 1u);
+    uint32_t segments =
+        std::min(size() + 1, std::max(1u, (count + min_grain - 1) / min_grain));
+    if (segments <= 1) {
+      func(0u, 0u, count);
+      return 1;
+    }
+    uint32_t step = (count + segments - 1) / segments;
+    std::latch done{static_cast<std::ptrdiff_t>(segments)};
+    // 任务可能在返回之后才开始执行，领不到段时只会访问计数器
+    auto next = std::make_shared<std::atomic<uint32_t>>(0u);
+    auto run = [next, &func, &done, count, step, segments] {
+      for (uint32_t i = next->fetch_add(1); i < segments;
+           i = next->fetch_add(1)) {
+        uint32_t begin = std::min(count, i * step);
+        uint32_t end = std::min(count, begin + step);
+        func(i, begin, end);
+        done.count_down();
+      }
+    };
+    for (uint32_t i = 1; i < segments; i++) {
+      submitUrgent(run);
+    }
+    run();
+    done.wait();
+    return segments;
+  }
+
+  uint32_t size() const { return static_cast<uint32_t>(m_workers.size()); }
+
+  ThreadPool(ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool &) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+};
+
+} // namespace engine::core
@@ -1,58 +1,121 @@
 #include "time.hpp"
 #include "SDL3/SDL_timer.h"
+#include "profiler.hpp"
 #include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <thread>
 
 namespace engine::core {
 
-Time::Time(uint32_t fps) : m_fps{fps} {
-  if (fps == 0) {
-    spdlog::trace("时间管理器初始化：不做帧限制");
-    m_frame_interval = 0.0;
-  } else {
-    spdlog::trace("时间管理器初始化：锁定帧数{}", fps);
-    m_frame_interval = 1.0 / fps;
-  }
-}
+namespace {
+// 自旋段在估计超时之外额外留出的余量
+constexpr uint64_t kSpinSlack = 200000;
+// 超时估计的上限，避免一次长时间卡顿后一直自旋
+constexpr uint64_t kMaxOvershoot = 4000000;
+} // namespace
+
+Time::Time(uint32_t fps) { setfps(fps); }
 Time::~Time() = default;
 
 void Time::init() {
   spdlog::trace("时间管理器初始化");
   m_last_frame_time = SDL_GetTicksNS();
-  m_start_frame_time = m_last_frame_time;
 }
 void Time::deinit() { spdlog::trace("时间管理器退出"); }
 
-void Time::limit(uint64_t l2s_interval) {
+void Time::limit(uint64_t deadline) {
+  TRIAL_PROFILE_ZONE("Time::limit");
+  uint64_t now = SDL_GetTicksNS();
+  if (m_pacing == PacingMode::Sleep) {
+    SDL_DelayNS(deadline - now);
+    return;
+  }
+  // 粗睡眠，留出估计的超时量
+  while (deadline > now && deadline - now > m_sleep_overshoot + kSpinSlack) {
+    uint64_t request = deadline - now - m_sleep_overshoot - kSpinSlack;
+    SDL_DelayNS(request);
+    uint64_t after = SDL_GetTicksNS();
+    uint64_t slept = after - now;
+    uint64_t overshoot = slept > request ? slept - request : 0;
+    if (overshoot > m_sleep_overshoot) {
+      m_sleep_overshoot = std::min(overshoot, kMaxOvershoot);
+    } else {
+      m_sleep_overshoot -= (m_sleep_overshoot - overshoot) / 16;
+    }
+    now = after;
+  }
+  // 剩下不到一个超时量的时间自旋等待
+  while (SDL_GetTicksNS() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+void Time::recordPacing(uint64_t interval) {
+  uint64_t error = interval > m_frame_interval ? interval - m_frame_interval
+                                               : m_frame_interval - interval;
+  m_pacing_errors[m_pacing_count % kPacingWindow] = error;
+  m_pacing_count++;
+}
 
-  uint64_t interval = static_cast<uint64_t>(m_frame_interval * 1000000000);
-  if (l2s_interval < interval) {
-    uint64_t delay_time = interval - l2s_interval;
-    SDL_DelayNS(delay_time);
-    m_delta_time = (SDL_GetTicksNS() - m_last_frame_time) / 1000000000.0;
+PacingStats Time::getPacingStats() const {
+  PacingStats ret;
+  ret.overshoot_ms = m_sleep_overshoot / 1e6;
+  ret.frames = std::min(m_pacing_count, kPacingWindow);
+  if (ret.frames == 0) {
+    return ret;
   }
+  auto errors = m_pacing_errors;
+  auto end = errors.begin() + ret.frames;
+  uint64_t total = 0;
+  for (auto it = errors.begin(); it != end; it++) {
+    total += *it;
+  }
+  ret.mean_ms = static_cast<double>(total) / ret.frames / 1e6;
+  auto p99 = errors.begin() + (ret.frames - 1) * 99 / 100;
+  std::nth_element(errors.begin(), p99, end);
+  ret.p99_ms = *p99 / 1e6;
+  return ret;
 }
 
 void Time::setfps(uint32_t fps) {
   m_fps = fps;
+  m_pacing_count = 0;
   if (fps == 0) {
     spdlog::trace("时间管理器初始化：不做帧限制");
-    m_frame_interval = 0.0;
+    m_frame_interval = 0;
   } else {
     spdlog::trace("时间管理器初始化：锁定帧数{}", fps);
-    m_frame_interval = 1.0 / fps;
+    m_frame_interval = 1000000000ull / fps;
   }
 }
 
+void Time::alignToRefreshRate(double refresh_rate) {
+  if (refresh_rate <= 0.0 || m_fps == 0) {
+    return;
+  }
+  // 取不超过目标帧率的最大的刷新率整数分之一，目标帧率高于刷新率时取刷新率
+  // 例如240Hz锁144帧时为120帧；减去0.01容忍60.001Hz这样略高的刷新率
+  double divisor = std::max(1.0, std::ceil(refresh_rate / m_fps - 0.01));
+  m_frame_interval = static_cast<uint64_t>(divisor * 1e9 / refresh_rate);
+  m_fps = static_cast<uint32_t>(std::lround(refresh_rate / divisor));
+  m_pacing_count = 0;
+  spdlog::trace("时间管理器按刷新率{:.2f}对齐：帧数{}", refresh_rate, m_fps);
+}
+
 void Time::update() {
-  m_start_frame_time = SDL_GetTicksNS();
-  uint64_t last_to_start_interval = m_start_frame_time - m_last_frame_time;
-  if (m_frame_interval > 0.0) {
-    limit(last_to_start_interval);
-  } else {
-    m_delta_time = last_to_start_interval / 1000000000.0;
+  uint64_t now = SDL_GetTicksNS();
+  if (m_frame_interval > 0) {
+    uint64_t deadline = m_last_frame_time + m_frame_interval;
+    if (now < deadline) {
+      limit(deadline);
+      now = SDL_GetTicksNS();
+    }
+    recordPacing(now - m_last_frame_time);
   }
-  m_last_frame_time = SDL_GetTicksNS();
+  m_delta_time = (now - m_last_frame_time) / 1000000000.0;
+  m_last_frame_time = now;
 }
 
 } // namespace engine::core
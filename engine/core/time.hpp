@@ -1,17 +1,45 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 namespace engine::core {
+
+// 帧率限制方式
+enum class PacingMode : uint8_t {
+  // 整段交给系统睡眠，精度取决于系统调度
+  Sleep,
+  // 先睡眠到截止时间前的余量，最后一段让出cpu自旋
+  Hybrid,
+};
+
+// 最近kPacingWindow帧的实际帧间隔和目标间隔的偏差
+struct PacingStats {
+  double mean_ms{0.0};
+  double p99_ms{0.0};
+  // 当前估计的系统睡眠超时
+  double overshoot_ms{0.0};
+  uint32_t frames{0};
+};
+
 class Time final {
+public:
+  static constexpr uint32_t kPacingWindow = 256;
+
 private:
   uint64_t m_last_frame_time{0};
-  uint64_t m_start_frame_time{0};
   double m_delta_time{0.0};
   uint32_t m_fps{0};
-  double m_frame_interval{0.0};
+  // 纳秒，0表示不限帧
+  uint64_t m_frame_interval{0};
+  PacingMode m_pacing{PacingMode::Hybrid};
+  // 睡眠比请求时间多出的部分，快速上升、缓慢回落
+  uint64_t m_sleep_overshoot{1000000};
+  std::array<uint64_t, kPacingWindow> m_pacing_errors{};
+  uint32_t m_pacing_count{0};
 
 private:
-  void limit(uint64_t);
+  void limit(uint64_t deadline);
+  void recordPacing(uint64_t interval);
 
 public:
   Time(uint32_t fps = 144);
@@ -20,9 +48,16 @@ public:
   void init();
   void deinit();
   void setfps(uint32_t);
+  // 按显示器刷新率调整目标帧率，使每帧占用整数个刷新周期
+  void alignToRefreshRate(double refresh_rate);
+  void setPacing(PacingMode mode) { m_pacing = mode; }
+  PacingMode getPacing() const { return m_pacing; }
   void update();
+  // 回放时用录制的帧间隔代替时钟测量的
+  void setDeltaTime(double dt) { m_delta_time = dt; }
   float getDeltaTime() const { return static_cast<float>(m_delta_time); }
   uint32_t getfps() const { return m_fps; }
+  PacingStats getPacingStats() const;
 
   Time(Time &) = delete;
   Time(Time &&) = delete;
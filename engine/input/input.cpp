@@ -1,101 +1,267 @@
 #include "input.hpp"
-#include <algorithm>
+#include "recording.hpp"
+#include "nlohmann/json.hpp"
+#include "spdlog/spdlog.h"
+#include <bit>
+#include <fstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace engine::input {
-void Manager::updateActionState(const std::string &action, bool is_down,
-                                bool repeat) {
-  auto it = m_action_status.find(action);
-  if (it == m_action_status.end()) {
-    return;
+using engine::core::StringId;
+
+Manager::Manager() {
+  // 没有绑定文件时使用的默认绑定
+  setBindings({
+      {"move up", {"w"}},
+      {"move down", {"s"}},
+      {"move left", {"a"}},
+      {"move right", {"d"}},
+      {"show menu", {"q"}},
+      {"show info", {"e"}},
+      {"attack", {"mouse left"}},
+      {"select", {"mouse left"}},
+      {"click", {"mouse left"}},
+      {"cancle", {"mouse right"}},
+  });
+}
+
+Manager::~Manager() = default;
+
+bool Manager::startRecording(std::string_view path, uint32_t tick_rate) {
+  auto recorder = std::make_unique<Recorder>();
+  if (!recorder->open(path, tick_rate)) {
+    return false;
   }
+  m_recorder = std::move(recorder);
+  spdlog::info("录制输入到{}", path);
+  return true;
+}
 
-  if (is_down) {
-    if (repeat)
-      it->second = ActionState::Held;
-    else
-      it->second = ActionState::Press;
-  } else {
-    it->second = ActionState::Release;
+bool Manager::startReplay(std::string_view path, uint32_t tick_rate) {
+  auto player = std::make_unique<Player>();
+  if (!player->open(path, tick_rate)) {
+    return false;
+  }
+  m_player = std::move(player);
+  spdlog::info("回放输入{}", path);
+  return true;
+}
+
+bool Manager::replayFinished() const {
+  return m_player && m_player->finished();
+}
+
+uint32_t Manager::getMouseButton(std::string_view key) {
+  if (key == "mouse left")
+    return SDL_BUTTON_LEFT;
+  else if (key == "mouse middle")
+    return SDL_BUTTON_MIDDLE;
+  else if (key == "mouse right")
+    return SDL_BUTTON_RIGHT;
+  else if (key == "mouse x1")
+    return SDL_BUTTON_X1;
+  else if (key == "mouse x2")
+    return SDL_BUTTON_X2;
+  return 0;
+}
+
+bool Manager::setBindings(const std::vector<Binding> &bindings) {
+  if (bindings.size() > kMaxActions) {
+    spdlog::error("动作数量{}超过上限{}", bindings.size(), kMaxActions);
+    return false;
+  }
+  decltype(m_key_table) key_table{};
+  decltype(m_mouse_table) mouse_table{};
+  decltype(m_actions) actions;
+  for (const auto &binding : bindings) {
+    auto index = static_cast<uint32_t>(actions.size());
+    auto [it, inserted] =
+        actions.try_emplace(StringId::intern(binding.action), index);
+    if (!inserted) {
+      spdlog::error("重复的动作{}", binding.action);
+      return false;
+    }
+    ActionMask bit = ActionMask{1} << it->second;
+    for (const auto &key : binding.keys) {
+      if (uint32_t button = getMouseButton(key); button != 0) {
+        mouse_table[button] |= bit;
+        continue;
+      }
+      SDL_Scancode scancode = SDL_GetScancodeFromName(key.c_str());
+      if (scancode == SDL_SCANCODE_UNKNOWN) {
+        spdlog::warn("动作{}绑定了未知按键{}", binding.action, key);
+        continue;
+      }
+      key_table[scancode] |= bit;
+    }
+  }
+  m_key_table = key_table;
+  m_mouse_table = mouse_table;
+  m_actions = std::move(actions);
+  m_down_count.fill(0);
+  m_down = m_latched = m_current = m_previous = 0;
+  return true;
+}
+
+bool Manager::loadBindings(std::string_view path) {
+  std::ifstream in{std::string{path}};
+  if (!in) {
+    spdlog::error("打开按键绑定{}失败", path);
+    return false;
+  }
+  nlohmann::json json = nlohmann::json::parse(in, nullptr, false);
+  if (json.is_discarded() || !json.is_object() ||
+      !json.value("actions", nlohmann::json{}).is_object()) {
+    spdlog::error("解析按键绑定{}失败", path);
+    return false;
+  }
+  std::vector<Binding> bindings;
+  for (const auto &[action, keys] : json["actions"].items()) {
+    Binding binding{.action = action, .keys = {}};
+    if (keys.is_string()) {
+      binding.keys.push_back(keys.get<std::string>());
+    } else if (keys.is_array()) {
+      for (const auto &key : keys) {
+        if (key.is_string()) {
+          binding.keys.push_back(key.get<std::string>());
+        }
+      }
+    }
+    bindings.push_back(std::move(binding));
+  }
+  if (!setBindings(bindings)) {
+    return false;
+  }
+  spdlog::trace("加载按键绑定{}，{}个动作", path, bindings.size());
+  return true;
+}
+
+void Manager::press(ActionMask mask) {
+  for (; mask != 0; mask &= mask - 1) {
+    m_down_count[std::countr_zero(mask)]++;
+  }
+}
+
+void Manager::release(ActionMask mask) {
+  for (; mask != 0; mask &= mask - 1) {
+    auto index = std::countr_zero(mask);
+    // 窗口获得焦点前按下的键只会收到松开
+    if (m_down_count[index] > 0 && --m_down_count[index] > 0) {
+      continue;
+    }
+    m_down &= ~(ActionMask{1} << index);
   }
 }
 
 void Manager::update(const SDL_Event &event) {
-  for (auto &[action, state] : m_action_status) {
-    if (state == ActionState::Press) {
-      state = ActionState::Held;
-    } else if (state == ActionState::Release) {
-      state = ActionState::None;
+  switch (event.type) {
+  case SDL_EVENT_QUIT:
+    m_quit = true;
+    break;
+  case SDL_EVENT_KEY_DOWN:
+    // 按住时的重复事件不改变状态
+    if (event.key.repeat) {
+      m_coalesced++;
+      return;
+    }
+    break;
+  case SDL_EVENT_MOUSE_MOTION:
+    // 和队尾连续的移动合并，位置取最新的，相对移动累加
+    if (!m_queue.empty() && m_queue.back().type == SDL_EVENT_MOUSE_MOTION &&
+        m_queue.back().motion.which == event.motion.which) {
+      auto &last = m_queue.back().motion;
+      float xrel = last.xrel + event.motion.xrel;
+      float yrel = last.yrel + event.motion.yrel;
+      last = event.motion;
+      last.xrel = xrel;
+      last.yrel = yrel;
+      m_coalesced++;
+      return;
     }
+    break;
+  default:
+    break;
   }
+  m_queue.push_back(event);
+}
 
+void Manager::apply(const SDL_Event &event) {
   switch (event.type) {
   case SDL_EVENT_KEY_DOWN:
   case SDL_EVENT_KEY_UP: {
-    SDL_Scancode keycode = event.key.scancode;
-    bool is_down = event.key.down;
-    bool is_repeat = event.key.repeat;
-    auto it = std::find_if(
-        m_key_binding.begin(), m_key_binding.end(),
-        [&keycode](const std::pair<std::string, std::vector<std::string>> &p) {
-          return getScancode(p.first) == keycode;
-        });
-    if (it != m_key_binding.end()) {
-      for (const auto &action : it->second) {
-        updateActionState(action, is_down, is_repeat);
-      }
+    if (event.key.repeat || event.key.scancode >= SDL_SCANCODE_COUNT) {
+      break;
+    }
+    ActionMask mask = m_key_table[event.key.scancode];
+    if (event.key.down) {
+      press(mask);
+      m_down |= mask;
+      m_latched |= mask;
+    } else {
+      release(mask);
     }
     break;
   }
   case SDL_EVENT_MOUSE_BUTTON_DOWN:
   case SDL_EVENT_MOUSE_BUTTON_UP: {
-    uint32_t button = event.button.button;
-    bool is_down = event.button.down;
-    auto it = std::find_if(
-        m_key_binding.begin(), m_key_binding.end(),
-        [&button](const std::pair<std::string, std::vector<std::string>> &p) {
-          return getMouseButtonUin32FromString(p.first) == button;
-        });
-    if (it != m_key_binding.end()) {
-      for (const auto &action : it->second) {
-        updateActionState(action, is_down, false);
-      }
+    if (event.button.button >= kMouseButtons) {
+      break;
+    }
+    ActionMask mask = m_mouse_table[event.button.button];
+    if (event.button.down) {
+      press(mask);
+      m_down |= mask;
+      m_latched |= mask;
+    } else {
+      release(mask);
     }
   } break;
   case SDL_EVENT_MOUSE_MOTION:
-    m_mouse_pos = glm::vec2{event.motion.x, event.motion.y};
-    break;
-  case SDL_EVENT_QUIT:
-    m_quit = true;
+    m_snapshot.mouse_pos = glm::vec2{event.motion.x, event.motion.y};
+    m_snapshot.mouse_delta += glm::vec2{event.motion.xrel, event.motion.yrel};
     break;
   default:
     break;
   }
 }
 
-bool Manager::isActionPress(const std::string &action) const {
-  const auto &it = m_action_status.find(action);
-  if (it != m_action_status.end()) {
-    return it->second == ActionState::Press ||
-           it->second == ActionState::Held;
+double Manager::beginFrame(double dt) {
+  if (m_player) {
+    m_queue.clear();
+    m_coalesced = 0;
+    m_player->next(dt, m_queue);
+  } else if (m_recorder) {
+    m_recorder->write(dt, m_queue);
   }
-  return false;
-}
-bool Manager::isActionHeld(const std::string &action) const {
-  const auto &it = m_action_status.find(action);
-  if (it != m_action_status.end()) {
-    return it->second == ActionState::Held;
+  m_snapshot.frame++;
+  m_snapshot.mouse_delta = glm::vec2{0.0f};
+  for (const auto &event : m_queue) {
+    apply(event);
   }
-  return false;
-}
-bool Manager::isActionRelease(const std::string &action) const {
-  const auto &it = m_action_status.find(action);
-  if (it != m_action_status.end()) {
-    return it->second == ActionState::Release;
+  if (!m_queue.empty()) {
+    m_snapshot.timestamp = m_queue.back().common.timestamp;
   }
-  return false;
+  // 交换缓冲，两边的容量都可以复用
+  m_snapshot.events.swap(m_queue);
+  m_queue.clear();
+  m_snapshot.coalesced = m_coalesced;
+  m_coalesced = 0;
+
+  m_previous = m_current;
+  m_current = m_down | m_latched;
+  m_latched = 0;
+  return dt;
+}
+
+ActionState Manager::getActionState(Action action) const {
+  bool current = test(m_current, action);
+  bool previous = test(m_previous, action);
+  if (current) {
+    return previous ? ActionState::Held : ActionState::Press;
   }
+  return previous ? ActionState::Release : ActionState::None;
+}
 
 } // namespace engine::input
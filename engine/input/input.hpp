@@ -1,16 +1,23 @@
 #pragma once
 
+#include "../core/string_id.hpp"
 #include "SDL3/SDL_events.h"
 #include "SDL3/SDL_keyboard.h"
 #include "SDL3/SDL_mouse.h"
 #include "SDL3/SDL_render.h"
 #include "glm/glm.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
 
 namespace engine::input {
+class Recorder;
+class Player;
+
 enum class ActionState {
   None,
   Press,
@@ -18,55 +25,133 @@ enum class ActionState {
   Release,
 };
 
+// 一个动作以及触发它的按键名，按键名和SDL_GetScancodeFromName一致
+// 鼠标按键写作"mouse left"、"mouse middle"、"mouse right"、"mouse x1"、"mouse x2"
+struct Binding {
+  std::string action;
+  std::vector<std::string> keys;
+};
+
+// 一帧的输入，beginFrame之后到下一次beginFrame之前不变
+struct Snapshot {
+  uint64_t frame{0};
+  // 本帧最后一个事件的SDL时间戳(ns)，没有事件时保留上一帧的值
+  uint64_t timestamp{0};
+  glm::vec2 mouse_pos{0.0f};
+  // 本帧鼠标移动的距离
+  glm::vec2 mouse_delta{0.0f};
+  // 合并之后的事件，按到达顺序，保留SDL的时间戳
+  std::vector<SDL_Event> events;
+  // 被合并或丢弃的事件数
+  uint32_t coalesced{0};
+};
+
+/*
+ * 事件先放进队列，每帧开始时统一处理，连续的鼠标移动合并成一个
+ * 绑定在加载时编译成按扫描码和鼠标按键索引的表，事件到达时直接查表
+ * 动作的状态保存为位集，每帧开始时计算一次边沿，查询只做位测试
+ */
 class Manager final {
+public:
+  static constexpr uint32_t kMaxActions = 64;
+  // 查询时不需要查哈希表，可以在初始化时保存
+  struct Action {
+    uint32_t index{kMaxActions};
+
+    bool valid() const { return index < kMaxActions; }
+  };
+
 private:
+  using ActionMask = uint64_t;
+  static constexpr uint32_t kMouseButtons = 8;
+
   bool m_quit{false};
-  glm::vec2 m_mouse_pos;
-  const std::unordered_map<std::string, std::vector<std::string>> m_key_binding{
-      {"w", {"move up"}},
-      {"s", {"move down"}},
-      {"a", {"move left"}},
-      {"d", {"move right"}},
-      {"q", {"show menu"}},
-      {"e", {"show info"}},
-      {"mouse left", {"attack", "select", "click"}},
-      {"mouse right", {"cancle"}}};
-
-  std::unordered_map<std::string, ActionState> m_action_status{
-      {"move down", ActionState::None}, {"move up", ActionState::None},
-      {"move left", ActionState::None}, {"move right", ActionState::None},
-      {"select", ActionState::None},    {"show menu", ActionState::None},
-      {"show info", ActionState::None}, {"attack", ActionState::None},
-      {"cancle", ActionState::None},    {"click", ActionState::None}};
+  // 上一帧之后收到的事件
+  std::vector<SDL_Event> m_queue;
+  uint32_t m_coalesced{0};
+  Snapshot m_snapshot;
+  // 录制时每帧写入处理前的事件，回放时用文件中的事件代替实时的
+  std::unique_ptr<Recorder> m_recorder;
+  std::unique_ptr<Player> m_player;
+  // 每个按键触发的动作
+  std::array<ActionMask, SDL_SCANCODE_COUNT> m_key_table{};
+  std::array<ActionMask, kMouseButtons> m_mouse_table{};
+  std::unordered_map<engine::core::StringId, uint32_t,
+                     engine::core::StringIdHash>
+      m_actions;
+  // 一个动作可以绑定多个按键，全部松开后才算松开
+  std::array<uint8_t, kMaxActions> m_down_count{};
+  // 事件实时更新的按下状态
+  ActionMask m_down{0};
+  // 上一帧之后按下过的动作，同一帧内按下又松开也能被看到
+  ActionMask m_latched{0};
+  ActionMask m_current{0};
+  ActionMask m_previous{0};
 
 private:
-  static inline SDL_Scancode getScancode(std::string_view key) {
-    return SDL_GetScancodeFromName(key.data());
-  }
-  static inline uint32_t getMouseButtonUin32FromString(std::string_view key) {
-    // 只需要鼠标左键
-    if (key == "mouse left")
-      return SDL_BUTTON_LEFT;
-    else if (key == "mouse right")
-      return SDL_BUTTON_RIGHT;
-    return 0;
+  static uint32_t getMouseButton(std::string_view key);
+  void apply(const SDL_Event &);
+  void press(ActionMask);
+  void release(ActionMask);
+  bool test(ActionMask mask, Action action) const {
+    return action.valid() && (mask >> action.index & 1) != 0;
   }
-  void updateActionState(const std::string &, bool, bool repeat = false);
 
 public:
-  Manager() = default;
-  ~Manager() = default;
+  Manager();
+  ~Manager();
+
+  // 从json文件加载绑定: {"actions": {"attack": ["mouse left"], ...}}
+  // 失败时保留原来的绑定
+  bool loadBindings(std::string_view path);
+  // 重新编译绑定表，已经按下的状态会被清空
+  bool setBindings(const std::vector<Binding> &);
 
   bool shouldQuit() const { return m_quit; }
   void setQuit(bool p = true) { m_quit = p; }
 
+  // 只放进队列，退出事件立即生效
   void update(const SDL_Event &);
+  // 每帧调用一次，处理队列中的事件，计算动作的边沿并生成快照
+  // 返回本帧使用的dt，回放时为录制的dt
+  double beginFrame(double dt);
+  // 录制输入和每帧的dt，tick_rate写入文件用于回放时检查
+  bool startRecording(std::string_view path, uint32_t tick_rate);
+  // 回放时忽略实时输入，退出事件除外
+  bool startReplay(std::string_view path, uint32_t tick_rate);
+  bool isReplaying() const { return m_player != nullptr; }
+  bool replayFinished() const;
+  const Snapshot &getSnapshot() const { return m_snapshot; }
+
+  Action findAction(engine::core::StringId id) const {
+    auto it = m_actions.find(id);
+    return it != m_actions.end() ? Action{it->second} : Action{};
+  }
 
-  bool isActionPress(const std::string &) const;
-  bool isActionHeld(const std::string &) const;
-  bool isActionRelease(const std::string &) const;
+  // 按下中，包括刚按下
+  bool isActionPress(Action action) const { return test(m_current, action); }
+  // 上一帧已经按下
+  bool isActionHeld(Action action) const {
+    return test(m_current & m_previous, action);
+  }
+  // 本帧松开
+  bool isActionRelease(Action action) const {
+    return test(m_previous & ~m_current, action);
+  }
+  ActionState getActionState(Action action) const;
+
+  // 动作名只做整数比较，字面量直接传入: isActionPress("attack")
+  bool isActionPress(engine::core::StringId id) const {
+    return isActionPress(findAction(id));
+  }
+  bool isActionHeld(engine::core::StringId id) const {
+    return isActionHeld(findAction(id));
+  }
+  bool isActionRelease(engine::core::StringId id) const {
+    return isActionRelease(findAction(id));
+  }
 
-  const glm::vec2 &getMousePos() const { return m_mouse_pos; }
+  const glm::vec2 &getMousePos() const { return m_snapshot.mouse_pos; }
 
   Manager(Manager &) = delete;
   Manager(Manager &&) = delete;
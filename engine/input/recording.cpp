@@ -0,0 +1,162 @@
+#include "recording.hpp"
+#include "spdlog/spdlog.h"
+#include <cstring>
+#include <iterator>
+#include <string>
+
+namespace engine::input {
+
+namespace {
+bool toRecord(const SDL_Event &event, RecordEvent &out) {
+  out = RecordEvent{};
+  out.timestamp = event.common.timestamp;
+  out.type = event.type;
+  switch (event.type) {
+  case SDL_EVENT_KEY_DOWN:
+  case SDL_EVENT_KEY_UP:
+    out.code = event.key.scancode;
+    out.down = event.key.down;
+    return true;
+  case SDL_EVENT_MOUSE_BUTTON_DOWN:
+  case SDL_EVENT_MOUSE_BUTTON_UP:
+    out.code = event.button.button;
+    out.down = event.button.down;
+    out.x = event.button.x;
+    out.y = event.button.y;
+    return true;
+  case SDL_EVENT_MOUSE_MOTION:
+    out.x = event.motion.x;
+    out.y = event.motion.y;
+    out.xrel = event.motion.xrel;
+    out.yrel = event.motion.yrel;
+    return true;
+  default:
+    return false;
+  }
+}
+
+SDL_Event fromRecord(const RecordEvent &record) {
+  SDL_Event event{};
+  event.type = record.type;
+  event.common.timestamp = record.timestamp;
+  switch (record.type) {
+  case SDL_EVENT_KEY_DOWN:
+  case SDL_EVENT_KEY_UP:
+    event.key.scancode = static_cast<SDL_Scancode>(record.code);
+    event.key.down = record.down != 0;
+    break;
+  case SDL_EVENT_MOUSE_BUTTON_DOWN:
+  case SDL_EVENT_MOUSE_BUTTON_UP:
+    event.button.button = static_cast<uint8_t>(record.code);
+    event.button.down = record.down != 0;
+    event.button.x = record.x;
+    event.button.y = record.y;
+    break;
+  case SDL_EVENT_MOUSE_MOTION:
+    event.motion.x = record.x;
+    event.motion.y = record.y;
+    event.motion.xrel = record.xrel;
+    event.motion.yrel = record.yrel;
+    break;
+  default:
+    break;
+  }
+  return event;
+}
+} // namespace
+
+Recorder::~Recorder() {
+  if (m_out.is_open()) {
+    spdlog::info("录制输入{}帧", m_frames);
+  }
+}
+
+bool Recorder::open(std::string_view path, uint32_t tick_rate) {
+  m_out.open(std::string{path}, std::ios::binary);
+  if (!m_out) {
+    spdlog::error("打开录制文件{}失败", path);
+    return false;
+  }
+  RecordHeader header{
+      .magic = kRecordMagic,
+      .version = kRecordVersion,
+      .tick_rate = tick_rate,
+      .flags = 0,
+  };
+  m_out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  return static_cast<bool>(m_out);
+}
+
+void Recorder::write(double dt, const std::vector<SDL_Event> &events) {
+  m_buffer.clear();
+  for (const auto &event : events) {
+    RecordEvent record;
+    if (toRecord(event, record)) {
+      m_buffer.push_back(record);
+    }
+  }
+  RecordFrame frame{
+      .dt = dt,
+      .events = static_cast<uint32_t>(m_buffer.size()),
+      .reserved = 0,
+  };
+  m_out.write(reinterpret_cast<const char *>(&frame), sizeof(frame));
+  m_out.write(reinterpret_cast<const char *>(m_buffer.data()),
+              static_cast<std::streamsize>(m_buffer.size() *
+                                           sizeof(RecordEvent)));
+  m_frames++;
+}
+
+bool Player::open(std::string_view path, uint32_t tick_rate) {
+  std::ifstream in{std::string{path}, std::ios::binary};
+  if (!in) {
+    spdlog::error("打开回放文件{}失败", path);
+    return false;
+  }
+  m_data.assign(std::istreambuf_iterator<char>{in},
+                std::istreambuf_iterator<char>{});
+  RecordHeader header;
+  if (m_data.size() < sizeof(header)) {
+    spdlog::error("回放文件{}格式错误", path);
+    return false;
+  }
+  std::memcpy(&header, m_data.data(), sizeof(header));
+  if (header.magic != kRecordMagic || header.version != kRecordVersion) {
+    spdlog::error("回放文件{}格式错误", path);
+    return false;
+  }
+  if (header.tick_rate != tick_rate) {
+    spdlog::warn("回放文件的更新频率{}和当前的{}不同，结果可能不一致",
+                 header.tick_rate, tick_rate);
+  }
+  m_offset = sizeof(header);
+  m_frame = 0;
+  return true;
+}
+
+bool Player::next(double &dt, std::vector<SDL_Event> &events) {
+  RecordFrame frame;
+  if (m_data.size() - m_offset < sizeof(frame)) {
+    m_offset = m_data.size();
+    return false;
+  }
+  std::memcpy(&frame, m_data.data() + m_offset, sizeof(frame));
+  size_t size = size_t{frame.events} * sizeof(RecordEvent);
+  if (m_data.size() - m_offset - sizeof(frame) < size) {
+    spdlog::error("回放文件在第{}帧截断", m_frame);
+    m_offset = m_data.size();
+    return false;
+  }
+  m_offset += sizeof(frame);
+  for (uint32_t i = 0; i < frame.events; i++) {
+    RecordEvent record;
+    std::memcpy(&record, m_data.data() + m_offset, sizeof(record));
+    m_offset += sizeof(record);
+    events.push_back(fromRecord(record));
+  }
+  dt = frame.dt;
+  m_frame++;
+  return true;
+}
+
+} // namespace engine::input
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "SDL3/SDL_events.h"
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+namespace engine::input {
+
+/*
+ * 输入录制文件，所有字段小端
+ * [RecordHeader][RecordFrame][RecordEvent]...[RecordFrame][RecordEvent]...
+ * 每帧保存本帧使用的dt和合并之后的输入事件，回放时原样送回输入管理器
+ */
+constexpr std::array<char, 4> kRecordMagic{'T', 'R', 'R', 'C'};
+constexpr uint32_t kRecordVersion = 1;
+
+struct RecordHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  // 录制时场景更新的频率，回放时不同会导致tick数不一致
+  uint32_t tick_rate;
+  uint32_t flags;
+};
+
+struct RecordFrame {
+  double dt;
+  uint32_t events;
+  uint32_t reserved;
+};
+
+// 只保存输入管理器用到的字段
+struct RecordEvent {
+  uint64_t timestamp;
+  uint32_t type;
+  // 按键为扫描码，鼠标按键为按键编号
+  uint32_t code;
+  float x;
+  float y;
+  float xrel;
+  float yrel;
+  uint8_t down;
+  uint8_t padding[7];
+};
+
+static_assert(sizeof(RecordHeader) == 16);
+static_assert(sizeof(RecordFrame) == 16);
+static_assert(sizeof(RecordEvent) == 40);
+
+class Recorder final {
+private:
+  std::ofstream m_out;
+  uint32_t m_frames{0};
+  std::vector<RecordEvent> m_buffer;
+
+public:
+  Recorder() = default;
+  ~Recorder();
+
+  bool open(std::string_view path, uint32_t tick_rate);
+  // 不是输入的事件不保存
+  void write(double dt, const std::vector<SDL_Event> &events);
+  uint32_t getFrameCount() const { return m_frames; }
+
+  Recorder(Recorder &) = delete;
+  Recorder(Recorder &&) = delete;
+  Recorder &operator=(Recorder &) = delete;
+  Recorder &operator=(Recorder &&) = delete;
+};
+
+class Player final {
+private:
+  // 整个文件读进内存，回放时不做文件io
+  std::vector<uint8_t> m_data;
+  size_t m_offset{0};
+  uint32_t m_frame{0};
+
+public:
+  Player() = default;
+  ~Player() = default;
+
+  bool open(std::string_view path, uint32_t tick_rate);
+  // 读取下一帧，文件结束或损坏时返回false
+  bool next(double &dt, std::vector<SDL_Event> &events);
+  bool finished() const { return m_offset >= m_data.size(); }
+  uint32_t getFrame() const { return m_frame; }
+
+  Player(Player &) = delete;
+  Player(Player &&) = delete;
+  Player &operator=(Player &) = delete;
+  Player &operator=(Player &&) = delete;
+};
+
+} // namespace engine::input
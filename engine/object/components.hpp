@@ -0,0 +1,95 @@
+#pragma once
+
+#include "../core/string_id.hpp"
+#include "../renderer/pipelines/base.hpp"
+#include "../resource_manager/handle.hpp"
+#include "glm/glm.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace engine::object {
+
+// 位置是中心点，prev是上一个tick的位置，绘制时插值
+struct Transform {
+  glm::vec2 pos{0.0f, 0.0f};
+  glm::vec2 prev{0.0f, 0.0f};
+};
+
+// 每秒移动的距离
+struct Velocity {
+  glm::vec2 value{0.0f, 0.0f};
+};
+
+// 和Tile相同的绘制参数，贴图由资源管理器持有
+struct Sprite {
+  engine::resource::TextureHandle texture;
+  glm::vec2 size{200.0f, 200.0f};
+  // 同一层同一贴图内的绘制顺序
+  float depth{0.0f};
+  // 绘制层，越大越靠上
+  uint8_t layer{0};
+  engine::render::BlendMode blend{engine::render::BlendMode::Opaque};
+};
+
+struct Name {
+  engine::core::StringId id;
+};
+
+/*
+ * 所有组件类型，下标即组件位
+ * 组件按块整体拷贝，必须可以平凡拷贝
+ */
+using ComponentList = std::tuple<Transform, Velocity, Sprite, Name>;
+constexpr uint32_t kComponentCount = std::tuple_size_v<ComponentList>;
+
+// 组件集合的位掩码
+using ComponentMask = uint32_t;
+
+namespace detail {
+template <typename T, typename Tuple> struct IndexOf;
+template <typename T, typename... Ts> struct IndexOf<T, std::tuple<T, Ts...>> {
+  static constexpr uint32_t value = 0;
+};
+template <typename T, typename U, typename... Ts>
+struct IndexOf<T, std::tuple<U, Ts...>> {
+  static constexpr uint32_t value = 1 + IndexOf<T, std::tuple<Ts...>>::value;
+};
+
+template <size_t... I>
+constexpr std::array<size_t, sizeof...(I)> sizes(std::index_sequence<I...>) {
+  return {sizeof(std::tuple_element_t<I, ComponentList>)...};
+}
+template <size_t... I>
+constexpr std::array<size_t, sizeof...(I)> aligns(std::index_sequence<I...>) {
+  return {alignof(std::tuple_element_t<I, ComponentList>)...};
+}
+template <size_t... I>
+constexpr bool trivial(std::index_sequence<I...>) {
+  return (
+      std::is_trivially_copyable_v<std::tuple_element_t<I, ComponentList>> &&
+      ...);
+}
+} // namespace detail
+
+template <typename T>
+constexpr uint32_t kComponentIndex = detail::IndexOf<T, ComponentList>::value;
+
+template <typename... Ts>
+constexpr ComponentMask kComponentMask = ((ComponentMask{1}
+                                           << kComponentIndex<Ts>) |
+                                          ... | 0u);
+
+constexpr auto kComponentSizes =
+    detail::sizes(std::make_index_sequence<kComponentCount>{});
+constexpr auto kComponentAligns =
+    detail::aligns(std::make_index_sequence<kComponentCount>{});
+
+static_assert(detail::trivial(std::make_index_sequence<kComponentCount>{}),
+              "组件必须可以平凡拷贝");
+static_assert(kComponentCount <= sizeof(ComponentMask) * 8);
+
+} // namespace engine::object
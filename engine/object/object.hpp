@@ -1,31 +1,78 @@
 #pragma once
 
 #include "../core/context.hpp"
+#include "../core/pool.hpp"
+#include "../core/string_id.hpp"
 #include "../renderer/renderer.hpp"
 #include "../renderer/tile.hpp"
+#include "../resource_manager/handle.hpp"
+#include <algorithm>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
+
+namespace engine::scene {
+class Scene;
+}
 
 namespace engine::object {
 
+struct ObjectTag;
+// 场景中对象的代数句柄，对象删除后查找返回空而不是悬空指针
+using ObjectHandle = engine::resource::Handle<ObjectTag>;
+
 // TODO maybe final
 class Object final {
+  friend class engine::scene::Scene;
+
 private:
   std::string m_name;
-  bool m_remove_flag;
-  std::unique_ptr<engine::render::Tile> m_tile;
+  // 按名字查找时只比较id
+  engine::core::StringId m_id;
+  // 分组用的标签，场景按标签建立索引
+  std::vector<engine::core::StringId> m_tags;
+  bool m_remove_flag{false};
+  // 加入场景时由场景分配
+  ObjectHandle m_handle;
+  engine::core::PoolPtr<engine::render::Tile> m_tile;
 
 public:
-  Object(std::string_view name) : m_name(name) {}
+  Object(std::string_view name)
+      : m_name(name), m_id{engine::core::StringId::intern(name)} {}
   ~Object() = default;
 
   bool needRemove() const { return m_remove_flag; }
+  // 没有加入场景时为空句柄
+  ObjectHandle getHandle() const { return m_handle; }
   void setRemove(bool flag = true) { m_remove_flag = flag; }
 
-  void setName(const std::string &name) { m_name = name; }
+  // 加入场景之后用Scene::renameObj修改，否则场景的索引不会更新
+  void setName(const std::string &name) {
+    m_name = name;
+    m_id = engine::core::StringId::intern(name);
+  }
   const std::string &getName() const { return m_name; }
+  engine::core::StringId getId() const { return m_id; }
+
+  // 加入场景之后用Scene::tagObj和untagObj修改
+  void addTag(engine::core::StringId tag) {
+    if (!hasTag(tag))
+      m_tags.push_back(tag);
+  }
+  bool removeTag(engine::core::StringId tag) {
+    auto it = std::find(m_tags.begin(), m_tags.end(), tag);
+    if (it == m_tags.end())
+      return false;
+    m_tags.erase(it);
+    return true;
+  }
+  bool hasTag(engine::core::StringId tag) const {
+    return std::find(m_tags.begin(), m_tags.end(), tag) != m_tags.end();
+  }
+  const std::vector<engine::core::StringId> &getTags() const { return m_tags; }
 
   template <typename... Args>
   void initTile(engine::core::Context &context, Args &&...args) {
@@ -38,13 +85,41 @@ public:
       m_tile->render();
   }
 
+  // 并行构建绘制列表时使用，只写入segment
+  void render(engine::render::SpriteSegment &segment) {
+    if (m_tile)
+      m_tile->render(segment);
+  }
+
+  // 世界坐标中的包围盒，没有tile时为空
+  std::optional<engine::render::AABB> getBounds() const {
+    if (m_tile)
+      return m_tile->getBounds();
+    return std::nullopt;
+  }
+
   // 移动tile
   void move(const glm::vec2 &d) { m_tile->move(d); }
 
+  // 每个tick开始前记录位置，用于渲染插值
+  void savePrevious() {
+    if (m_tile)
+      m_tile->savePrevious();
+  }
+
+  // 绘制层，越大越靠上
+  void setLayer(uint8_t layer) {
+    if (m_tile)
+      m_tile->setLayer(layer);
+  }
+
   Object(Object &) = delete;
   Object(Object &&) = delete;
   Object &operator=(Object &) = delete;
   Object &operator=(Object &&) = delete;
 };
 
+// 场景的对象池分配，也可以接收std::make_unique创建的对象
+using ObjectPtr = engine::core::PoolPtr<Object>;
+
 } // namespace engine::object
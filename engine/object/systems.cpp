@@ -0,0 +1,46 @@
+#include "systems.hpp"
+#include "../renderer/renderer.hpp"
+#include "../renderer/sprite_batch.hpp"
+#include "../resource_manager/resource_manager.hpp"
+
+namespace engine::object {
+
+void buildSprites(const Chunk &chunk, const engine::render::AABB &view,
+                  const engine::render::Renderer &renderer,
+                  const engine::resource::Manager &resources,
+                  engine::render::SpriteSegment &segment) {
+  const Transform *transforms = chunk.get<Transform>();
+  const Sprite *sprites = chunk.get<Sprite>();
+  float alpha = renderer.getInterpolation();
+  for (uint32_t i = 0; i < chunk.size(); i++) {
+    const Transform &transform = transforms[i];
+    const Sprite &sprite = sprites[i];
+    // 包含上一个tick的位置，插值后仍在包围盒内
+    glm::vec2 half = sprite.size * 0.5f;
+    engine::render::AABB bounds{
+        .min = glm::min(transform.prev, transform.pos) - half,
+        .max = glm::max(transform.prev, transform.pos) + half};
+    if (!bounds.intersects(view)) {
+      segment.culled++;
+      continue;
+    }
+    // 贴图加载完成前和被驱逐后不绘制
+    const engine::render::TextureRegion *region =
+        resources.textureGet(sprite.texture);
+    if (!region) {
+      continue;
+    }
+    engine::render::TileInfo info{
+        .pos = glm::mix(transform.prev, transform.pos, alpha),
+        .size = sprite.size,
+        .uv = region->uv,
+    };
+    segment.submit(
+        renderer.makeSpriteKey(sprite.layer, *region, sprite.depth,
+                               sprite.blend),
+        region->texture, info);
+    segment.visible++;
+  }
+}
+
+} // namespace engine::object
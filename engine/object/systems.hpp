@@ -0,0 +1,48 @@
+#pragma once
+
+#include "world.hpp"
+#include <cstdint>
+
+namespace engine::render {
+class Renderer;
+struct AABB;
+struct SpriteSegment;
+} // namespace engine::render
+
+namespace engine::resource {
+class Manager;
+}
+
+namespace engine::object {
+
+// 每个tick开始前记录插值起点
+inline void savePrevious(World &world) {
+  world.forEachChunk<Transform>(
+      [](uint32_t count, const Entity *, Transform *transforms) {
+        for (uint32_t i = 0; i < count; i++) {
+          transforms[i].prev = transforms[i].pos;
+        }
+      });
+}
+
+// 按速度移动
+inline void integrate(World &world, float dt) {
+  world.forEachChunk<Transform, Velocity>(
+      [dt](uint32_t count, const Entity *, Transform *transforms,
+           Velocity *velocities) {
+        for (uint32_t i = 0; i < count; i++) {
+          transforms[i].pos += velocities[i].value * dt;
+        }
+      });
+}
+
+/*
+ * 剔除并提交一块中的精灵，块中必须有Transform和Sprite
+ * 只读渲染器和资源管理器，只写segment，可以在工作线程调用
+ */
+void buildSprites(const Chunk &chunk, const engine::render::AABB &view,
+                  const engine::render::Renderer &renderer,
+                  const engine::resource::Manager &resources,
+                  engine::render::SpriteSegment &segment);
+
+} // namespace engine::object
@@ -0,0 +1,165 @@
+#include "world.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+
+namespace engine::object {
+
+namespace {
+constexpr uint32_t alignUp(uint32_t value, uint32_t align) {
+  return (value + align - 1) / align * align;
+}
+
+static_assert(std::ranges::all_of(kComponentAligns, [](size_t align) {
+  return align <= __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+}));
+} // namespace
+
+uint32_t World::findArchetype(ComponentMask mask) {
+  if (auto it = m_archetype_index.find(mask); it != m_archetype_index.end()) {
+    return it->second;
+  }
+  auto archetype = std::make_unique<Archetype>();
+  archetype->mask = mask;
+  uint32_t stride = sizeof(Entity);
+  for (uint32_t i = 0; i < kComponentCount; i++) {
+    if (mask & (ComponentMask{1} << i)) {
+      stride += static_cast<uint32_t>(kComponentSizes[i]);
+    }
+  }
+  // 每个数组的对齐最多浪费一个对齐的大小
+  uint32_t slack = (kComponentCount + 1) * __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+  archetype->capacity = static_cast<uint32_t>((Chunk::kBytes - slack) / stride);
+  uint32_t offset = sizeof(Entity) * archetype->capacity;
+  for (uint32_t i = 0; i < kComponentCount; i++) {
+    if (!(mask & (ComponentMask{1} << i))) {
+      archetype->offsets[i] = Chunk::kNoColumn;
+      continue;
+    }
+    offset = alignUp(offset, static_cast<uint32_t>(kComponentAligns[i]));
+    archetype->offsets[i] = offset;
+    offset += static_cast<uint32_t>(kComponentSizes[i]) * archetype->capacity;
+  }
+  auto index = static_cast<uint32_t>(m_archetypes.size());
+  m_archetypes.push_back(std::move(archetype));
+  m_archetype_index.emplace(mask, index);
+  spdlog::trace("创建原型{:#x}，每块{}个实体", mask,
+                m_archetypes.back()->capacity);
+  return index;
+}
+
+Entity World::allocEntity() {
+  uint32_t index = m_free;
+  if (index != kNone) {
+    m_free = m_records[index].next_free;
+  } else {
+    index = static_cast<uint32_t>(m_records.size());
+    m_records.emplace_back();
+  }
+  m_size++;
+  return Entity{.index = index, .generation = m_records[index].generation};
+}
+
+Chunk &World::allocRow(uint32_t archetype_index, Entity entity) {
+  Archetype &archetype = *m_archetypes[archetype_index];
+  if (archetype.chunks.empty() ||
+      archetype.chunks.back()->m_count == archetype.capacity) {
+    auto chunk = std::make_unique<Chunk>();
+    chunk->m_data = std::make_unique<std::byte[]>(Chunk::kBytes);
+    chunk->m_offsets = &archetype.offsets;
+    archetype.chunks.push_back(std::move(chunk));
+  }
+  Chunk &chunk = *archetype.chunks.back();
+  uint32_t row = chunk.m_count++;
+  reinterpret_cast<Entity *>(chunk.m_data.get())[row] = entity;
+  Record &rec = m_records[entity.index];
+  rec.archetype = archetype_index;
+  rec.chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+  rec.row = row;
+  return chunk;
+}
+
+void World::freeRow(const Record &rec) {
+  Archetype &archetype = *m_archetypes[rec.archetype];
+  Chunk &chunk = *archetype.chunks[rec.chunk];
+  Chunk &last = *archetype.chunks.back();
+  uint32_t last_row = last.m_count - 1;
+  if (&chunk != &last || rec.row != last_row) {
+    Entity moved = last.entities()[last_row];
+    reinterpret_cast<Entity *>(chunk.m_data.get())[rec.row] = moved;
+    for (uint32_t i = 0; i < kComponentCount; i++) {
+      if (archetype.offsets[i] == Chunk::kNoColumn) {
+        continue;
+      }
+      size_t size = kComponentSizes[i];
+      std::memcpy(static_cast<std::byte *>(chunk.column(i)) + size * rec.row,
+                  static_cast<std::byte *>(last.column(i)) + size * last_row,
+                  size);
+    }
+    Record &moved_rec = m_records[moved.index];
+    moved_rec.chunk = rec.chunk;
+    moved_rec.row = rec.row;
+  }
+  if (--last.m_count == 0) {
+    archetype.chunks.pop_back();
+  }
+}
+
+Chunk &World::migrate(Entity entity, ComponentMask mask) {
+  Record old = m_records[entity.index];
+  Chunk &from = chunkOf(old);
+  Chunk &to = allocRow(findArchetype(mask), entity);
+  uint32_t row = to.m_count - 1;
+  for (uint32_t i = 0; i < kComponentCount; i++) {
+    if ((*from.m_offsets)[i] == Chunk::kNoColumn ||
+        (*to.m_offsets)[i] == Chunk::kNoColumn) {
+      continue;
+    }
+    size_t size = kComponentSizes[i];
+    std::memcpy(static_cast<std::byte *>(to.column(i)) + size * row,
+                static_cast<std::byte *>(from.column(i)) + size * old.row,
+                size);
+  }
+  // 新位置已经写入记录，空出的旧位置由最后一行填补
+  freeRow(old);
+  return to;
+}
+
+bool World::destroy(Entity entity) {
+  const Record *rec = record(entity);
+  if (!rec) {
+    return false;
+  }
+  freeRow(*rec);
+  Record &slot = m_records[entity.index];
+  slot.archetype = kNone;
+  // 跳过0，空实体永远不会匹配
+  if (++slot.generation == 0) {
+    slot.generation = 1;
+  }
+  slot.next_free = m_free;
+  m_free = entity.index;
+  m_size--;
+  return true;
+}
+
+void World::clear() {
+  for (auto &archetype : m_archetypes) {
+    archetype->chunks.clear();
+  }
+  for (uint32_t i = 0; i < m_records.size(); i++) {
+    Record &rec = m_records[i];
+    if (rec.archetype == kNone) {
+      continue;
+    }
+    rec.archetype = kNone;
+    if (++rec.generation == 0) {
+      rec.generation = 1;
+    }
+    rec.next_free = m_free;
+    m_free = i;
+  }
+  m_size = 0;
+}
+
+} // namespace engine::object
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "components.hpp"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace engine::object {
+
+// 实体只是一个代数句柄，销毁后旧句柄查找返回空
+struct Entity {
+  uint32_t index{0};
+  // 0表示空实体
+  uint32_t generation{0};
+
+  bool valid() const { return generation != 0; }
+  bool operator==(const Entity &) const = default;
+};
+
+/*
+ * 一块固定大小的内存，保存同一组件集合的一组实体
+ * 每个组件一个连续数组(SoA)，系统按块遍历，内层循环没有指针跳转
+ * 除了最后一块，同一原型的块总是满的
+ */
+class Chunk final {
+  friend class World;
+
+public:
+  static constexpr size_t kBytes = 16 * 1024;
+
+private:
+  static constexpr uint32_t kNoColumn = std::numeric_limits<uint32_t>::max();
+
+  std::unique_ptr<std::byte[]> m_data;
+  // 每个组件数组在块中的偏移，不在原型中的组件为kNoColumn
+  const std::array<uint32_t, kComponentCount> *m_offsets{nullptr};
+  uint32_t m_count{0};
+
+  void *column(uint32_t index) {
+    return m_data.get() + (*m_offsets)[index];
+  }
+
+public:
+  uint32_t size() const { return m_count; }
+  // 实体数组放在块的最前面
+  const Entity *entities() const {
+    return reinterpret_cast<const Entity *>(m_data.get());
+  }
+
+  // 原型中没有该组件时返回空
+  template <typename T> T *get() {
+    uint32_t offset = (*m_offsets)[kComponentIndex<T>];
+    return offset == kNoColumn
+               ? nullptr
+               : reinterpret_cast<T *>(m_data.get() + offset);
+  }
+  template <typename T> const T *get() const {
+    return const_cast<Chunk *>(this)->get<T>();
+  }
+};
+
+/*
+ * 按原型(组件集合)分块存储的实体
+ * 结构变化(创建、销毁、增删组件)会移动实体，遍历过程中需要记录到CommandBuffer
+ * 不是线程安全的，遍历时可以把块分给工作线程，只写自己块中的组件
+ */
+class World final {
+private:
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+
+  struct Archetype {
+    ComponentMask mask{0};
+    // 每块的实体数
+    uint32_t capacity{0};
+    std::array<uint32_t, kComponentCount> offsets{};
+    std::vector<std::unique_ptr<Chunk>> chunks;
+  };
+  struct Record {
+    uint32_t archetype{kNone};
+    uint32_t chunk{0};
+    uint32_t row{0};
+    uint32_t generation{1};
+    uint32_t next_free{kNone};
+  };
+
+  std::vector<std::unique_ptr<Archetype>> m_archetypes;
+  std::unordered_map<ComponentMask, uint32_t> m_archetype_index;
+  std::vector<Record> m_records;
+  uint32_t m_free{kNone};
+  uint32_t m_size{0};
+
+private:
+  uint32_t findArchetype(ComponentMask mask);
+  Entity allocEntity();
+  // 在原型的最后一块末尾放一行，返回所在的块
+  Chunk &allocRow(uint32_t archetype, Entity entity);
+  // 用最后一行填补空位
+  void freeRow(const Record &);
+  // 移到另一个原型，保留两边都有的组件
+  Chunk &migrate(Entity entity, ComponentMask mask);
+  const Record *record(Entity entity) const {
+    if (entity.index >= m_records.size()) {
+      return nullptr;
+    }
+    const Record &rec = m_records[entity.index];
+    return rec.archetype != kNone && rec.generation == entity.generation
+               ? &rec
+               : nullptr;
+  }
+  Chunk &chunkOf(const Record &rec) {
+    return *m_archetypes[rec.archetype]->chunks[rec.chunk];
+  }
+
+public:
+  World() = default;
+  ~World() = default;
+
+  template <typename... Ts> Entity create(const Ts &...components) {
+    constexpr ComponentMask mask = kComponentMask<Ts...>;
+    static_assert(std::popcount(mask) == sizeof...(Ts), "组件类型重复");
+    Entity entity = allocEntity();
+    Chunk &chunk = allocRow(findArchetype(mask), entity);
+    uint32_t row = chunk.m_count - 1;
+    ((chunk.get<Ts>()[row] = components), ...);
+    return entity;
+  }
+  bool destroy(Entity entity);
+  bool alive(Entity entity) const { return record(entity) != nullptr; }
+  void clear();
+
+  // 实体已经销毁或没有该组件时返回空，指针在下一次结构变化前有效
+  template <typename T> T *get(Entity entity) {
+    const Record *rec = record(entity);
+    if (!rec) {
+      return nullptr;
+    }
+    T *column = chunkOf(*rec).get<T>();
+    return column ? column + rec->row : nullptr;
+  }
+  template <typename T> const T *get(Entity entity) const {
+    return const_cast<World *>(this)->get<T>(entity);
+  }
+  template <typename T> bool has(Entity entity) const {
+    return get<T>(entity) != nullptr;
+  }
+
+  // 已经有该组件时直接覆盖
+  template <typename T> bool add(Entity entity, const T &component) {
+    if (T *existing = get<T>(entity)) {
+      *existing = component;
+      return true;
+    }
+    const Record *rec = record(entity);
+    if (!rec) {
+      return false;
+    }
+    ComponentMask mask =
+        m_archetypes[rec->archetype]->mask | kComponentMask<T>;
+    Chunk &chunk = migrate(entity, mask);
+    chunk.get<T>()[m_records[entity.index].row] = component;
+    return true;
+  }
+  template <typename T> bool remove(Entity entity) {
+    if (!has<T>(entity)) {
+      return false;
+    }
+    const Record *rec = record(entity);
+    migrate(entity, m_archetypes[rec->archetype]->mask & ~kComponentMask<T>);
+    return true;
+  }
+
+  // 遍历包含所有Ts的块，fn(count, entities, Ts *...)
+  template <typename... Ts, typename F> void forEachChunk(F &&fn) {
+    constexpr ComponentMask mask = kComponentMask<Ts...>;
+    for (auto &archetype : m_archetypes) {
+      if ((archetype->mask & mask) != mask) {
+        continue;
+      }
+      for (auto &chunk : archetype->chunks) {
+        fn(chunk->size(), chunk->entities(), chunk->template get<Ts>()...);
+      }
+    }
+  }
+  // 逐个实体遍历，fn(Ts &...)
+  template <typename... Ts, typename F> void each(F &&fn) {
+    forEachChunk<Ts...>(
+        [&fn](uint32_t count, const Entity *, Ts *...columns) {
+          for (uint32_t i = 0; i < count; i++) {
+            fn(columns[i]...);
+          }
+        });
+  }
+  // 收集包含所有Ts的块，用于把块分给工作线程
+  template <typename... Ts> void collectChunks(std::vector<Chunk *> &out) {
+    constexpr ComponentMask mask = kComponentMask<Ts...>;
+    out.clear();
+    for (auto &archetype : m_archetypes) {
+      if ((archetype->mask & mask) == mask) {
+        for (auto &chunk : archetype->chunks) {
+          out.push_back(chunk.get());
+        }
+      }
+    }
+  }
+
+  uint32_t size() const { return m_size; }
+  uint32_t getArchetypeCount() const {
+    return static_cast<uint32_t>(m_archetypes.size());
+  }
+
+  World(World &) = delete;
+  World(World &&) = delete;
+  World &operator=(World &) = delete;
+  World &operator=(World &&) = delete;
+};
+
+/*
+ * 延迟执行的结构变化，遍历结束后由apply统一执行
+ * 不是线程安全的，每个线程使用自己的命令缓冲
+ */
+class CommandBuffer final {
+private:
+  std::vector<std::function<void(World &)>> m_commands;
+
+public:
+  template <typename... Ts> void create(const Ts &...components) {
+    m_commands.emplace_back(
+        [components...](World &world) { world.create(components...); });
+  }
+  void destroy(Entity entity) {
+    m_commands.emplace_back([entity](World &world) { world.destroy(entity); });
+  }
+  template <typename T> void add(Entity entity, const T &component) {
+    m_commands.emplace_back(
+        [entity, component](World &world) { world.add(entity, component); });
+  }
+  template <typename T> void remove(Entity entity) {
+    m_commands.emplace_back(
+        [entity](World &world) { world.template remove<T>(entity); });
+  }
+
+  // 按记录的顺序执行，作用在已销毁实体上的命令被忽略
+  void apply(World &world) {
+    for (auto &command : m_commands) {
+      command(world);
+    }
+    m_commands.clear();
+  }
+  bool empty() const { return m_commands.empty(); }
+  uint32_t size() const { return static_cast<uint32_t>(m_commands.size()); }
+  void clear() { m_commands.clear(); }
+};
+
+} // namespace engine::object
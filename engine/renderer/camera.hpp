@@ -0,0 +1,84 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace engine::render {
+
+// 世界坐标中的轴对齐包围盒
+struct AABB {
+  glm::vec2 min{0.0f, 0.0f};
+  glm::vec2 max{0.0f, 0.0f};
+
+  bool intersects(const AABB &other) const {
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y;
+  }
+};
+
+/*
+ * 2d相机，世界坐标以像素为单位，y轴向上
+ * position是视口中心对应的世界坐标
+ */
+class Camera final {
+private:
+  glm::vec2 m_position{0.0f, 0.0f};
+  float m_zoom{1.0f};
+  // 弧度，逆时针
+  float m_rotation{0.0f};
+  glm::vec2 m_viewport{1.0f, 1.0f};
+
+public:
+  Camera() = default;
+  ~Camera() = default;
+
+  void setPosition(const glm::vec2 &val) { m_position = val; }
+  const glm::vec2 &getPosition() const { return m_position; }
+  void move(const glm::vec2 &val) { m_position += val; }
+  void setZoom(float val) { m_zoom = std::max(val, 0.001f); }
+  float getZoom() const { return m_zoom; }
+  void setRotation(float val) { m_rotation = val; }
+  float getRotation() const { return m_rotation; }
+  void setViewport(const glm::vec2 &val) { m_viewport = val; }
+  const glm::vec2 &getViewport() const { return m_viewport; }
+
+  // 世界坐标到裁剪空间
+  glm::mat4 getViewProjection() const {
+    float c = std::cos(-m_rotation);
+    float s = std::sin(-m_rotation);
+    float sx = 2.0f * m_zoom / m_viewport.x;
+    float sy = 2.0f * m_zoom / m_viewport.y;
+    // 先平移到相机，再反向旋转，最后缩放到ndc
+    glm::mat4 ret{1.0f};
+    ret[0] = glm::vec4{c * sx, s * sy, 0.0f, 0.0f};
+    ret[1] = glm::vec4{-s * sx, c * sy, 0.0f, 0.0f};
+    ret[3] = glm::vec4{
+        -(c * m_position.x - s * m_position.y) * sx,
+        -(s * m_position.x + c * m_position.y) * sy,
+        0.0f,
+        1.0f,
+    };
+    return ret;
+  }
+
+  // 可见区域的包围盒，旋转时取四个角的外包
+  AABB getViewBounds() const {
+    glm::vec2 half = m_viewport * (0.5f / m_zoom);
+    float c = std::abs(std::cos(m_rotation));
+    float s = std::abs(std::sin(m_rotation));
+    glm::vec2 extent{half.x * c + half.y * s, half.x * s + half.y * c};
+    return AABB{.min = m_position - extent, .max = m_position + extent};
+  }
+
+  bool isVisible(const AABB &bounds) const {
+    return getViewBounds().intersects(bounds);
+  }
+
+  Camera(Camera &) = delete;
+  Camera(Camera &&) = delete;
+  Camera &operator=(Camera &) = delete;
+  Camera &operator=(Camera &&) = delete;
+};
+
+} // namespace engine::render
@@ -0,0 +1,47 @@
+#include "draw_list.hpp"
+#include <array>
+#include <utility>
+
+namespace engine::render {
+
+void DrawList::sort() {
+  if (m_items.size() < 2) {
+    return;
+  }
+  m_scratch.resize(m_items.size());
+
+  // 一次遍历统计8个字节的直方图
+  std::array<std::array<uint32_t, 256>, 8> histograms{};
+  for (const auto &item : m_items) {
+    for (uint32_t pass = 0; pass < 8; pass++) {
+      histograms[pass][(item.key >> (pass * 8)) & 0xff]++;
+    }
+  }
+
+  uint32_t count = static_cast<uint32_t>(m_items.size());
+  DrawItem *src = m_items.data();
+  DrawItem *dst = m_scratch.data();
+  for (uint32_t pass = 0; pass < 8; pass++) {
+    auto &histogram = histograms[pass];
+    uint32_t shift = pass * 8;
+    // 所有键在这个字节上相同，不需要这一趟
+    if (histogram[(src[0].key >> shift) & 0xff] == count) {
+      continue;
+    }
+    uint32_t offset = 0;
+    for (auto &bucket : histogram) {
+      uint32_t n = bucket;
+      bucket = offset;
+      offset += n;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+  if (src != m_items.data()) {
+    m_items.swap(m_scratch);
+  }
+}
+
+} // namespace engine::render
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace engine::render {
+
+/*
+ * 64位排序键
+ * | layer 8 | pipeline 8 | texture 16 | depth 32 |
+ * 排序后同一层内相同管线、相同贴图的绘制相邻，只在键变化处切换状态
+ */
+struct DrawKey {
+  static constexpr uint64_t make(uint8_t layer, uint8_t pipeline,
+                                 uint16_t texture, float depth) {
+    return (uint64_t{layer} << 56) | (uint64_t{pipeline} << 48) |
+           (uint64_t{texture} << 32) | depthBits(depth);
+  }
+
+  // float转换成可以按无符号整数比较的位模式
+  static constexpr uint32_t depthBits(float depth) {
+    uint32_t bits = std::bit_cast<uint32_t>(depth);
+    return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  }
+
+  static constexpr uint8_t layer(uint64_t key) {
+    return static_cast<uint8_t>(key >> 56);
+  }
+  static constexpr uint8_t pipeline(uint64_t key) {
+    return static_cast<uint8_t>(key >> 48);
+  }
+  static constexpr uint16_t texture(uint64_t key) {
+    return static_cast<uint16_t>(key >> 32);
+  }
+};
+
+struct DrawItem {
+  uint64_t key;
+  // 由提交者解释，一般是实例数组下标
+  uint32_t payload;
+};
+
+/*
+ * 每帧的绘制列表，基数排序
+ */
+class DrawList final {
+private:
+  std::vector<DrawItem> m_items;
+  std::vector<DrawItem> m_scratch;
+
+public:
+  DrawList() = default;
+  ~DrawList() = default;
+
+  void submit(uint64_t key, uint32_t payload) {
+    m_items.push_back(DrawItem{.key = key, .payload = payload});
+  }
+
+  // 稳定的LSD基数排序，所有键该字节相同的趟次直接跳过
+  void sort();
+  void clear() { m_items.clear(); }
+  void reserve(uint32_t count) { m_items.reserve(count); }
+
+  bool empty() const { return m_items.empty(); }
+  uint32_t size() const { return static_cast<uint32_t>(m_items.size()); }
+  const std::vector<DrawItem> &getItems() const { return m_items; }
+
+  DrawList(DrawList &) = delete;
+  DrawList(DrawList &&) = delete;
+  DrawList &operator=(DrawList &) = delete;
+  DrawList &operator=(DrawList &&) = delete;
+};
+
+} // namespace engine::render
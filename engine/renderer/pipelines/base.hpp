@@ -1,15 +1,11 @@
 #pragma once
 
 #include "glm/glm.hpp"
-#include "spdlog/spdlog.h"
-#include <SDL3/SDL_error.h>
 #include <SDL3/SDL_gpu.h>
-#include <SDL3/SDL_iostream.h>
-#include <SDL3/SDL_stdinc.h>
-#include <SDL3/SDL_video.h>
 #include <cstddef>
 #include <cstdint>
-#include <filesystem>
+#include <string>
+#include <string_view>
 
 namespace engine::render {
 
@@ -25,71 +21,92 @@ struct ShaderConfig {
   uint32_t storage_buff_count{0};
   uint32_t storage_texture_count{0};
   SDL_GPUShaderStage shader_stage{SDL_GPU_SHADERSTAGE_VERTEX};
+
+  bool operator==(const ShaderConfig &) const = default;
 };
 
-static SDL_GPUShader *loadShader(SDL_GPUDevice *device,
-                                 const std::filesystem::path &file,
-                                 const ShaderConfig &config) {
-  size_t code_size;
-  void *code = SDL_LoadFile(file.string().data(), &code_size);
-  if (!code) {
-    spdlog::error("加载shader文件 {}失败 {}", file.string(), SDL_GetError());
-    return nullptr;
-  }
-  SDL_GPUShaderCreateInfo create_info{
-      .code_size = code_size,
-      .code = static_cast<uint8_t *>(code),
-      .entrypoint = "main",
-      .format = SDL_GPU_SHADERFORMAT_SPIRV, // 只考虑用spirv
-      .stage = config.shader_stage,
-      .num_samplers = config.sample_count,
-      .num_storage_textures = config.storage_texture_count,
-      .num_storage_buffers = config.storage_buff_count,
-      .num_uniform_buffers = config.uniform_buff_count,
-      .props = 0,
-  };
-  SDL_GPUShader *shader = SDL_CreateGPUShader(device, &create_info);
-  if (!shader) {
-    spdlog::error("加载shader文件 {}失败 {}", file.string(), SDL_GetError());
-    SDL_free(code);
-    return nullptr;
+enum class BlendMode : uint8_t { Opaque, Alpha, Additive };
+
+// 顶点输入布局，目前只有VertexInput组成的四边形
+enum class VertexLayout : uint8_t { Quad };
+
+// FNV-1a，用于组合描述符的哈希
+constexpr uint64_t hashBytes(const void *data, size_t size,
+                             uint64_t hash = 14695981039346656037ull) {
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 1099511628211ull;
   }
+  return hash;
+}
+
+template <typename T>
+constexpr uint64_t hashValue(const T &val, uint64_t hash) {
+  return hashBytes(&val, sizeof(T), hash);
+}
+
+inline uint64_t hashValue(std::string_view val, uint64_t hash) {
+  return hashBytes(val.data(), val.size(), hash);
+}
 
-  SDL_free(code);
-  return shader;
+inline uint64_t hashValue(const ShaderConfig &config, uint64_t hash) {
+  hash = hashValue(config.sample_count, hash);
+  hash = hashValue(config.uniform_buff_count, hash);
+  hash = hashValue(config.storage_buff_count, hash);
+  hash = hashValue(config.storage_texture_count, hash);
+  return hashValue(config.shader_stage, hash);
 }
 
-class BasePipeline {
-  friend class Renderer;
-
-protected:
-  SDL_GPUDevice *m_device;
-  SDL_Window *m_window;
-  SDL_GPUGraphicsPipeline *m_pipeline;
-
-  // shader配置
-  ShaderConfig m_vert_config{.shader_stage = SDL_GPU_SHADERSTAGE_VERTEX};
-  ShaderConfig m_frag_config{.shader_stage = SDL_GPU_SHADERSTAGE_FRAGMENT};
-
-public:
-  BasePipeline(SDL_GPUDevice *device, SDL_Window *window)
-      : m_device{device}, m_window{window} {}
-  virtual ~BasePipeline() {
-    if (m_pipeline && m_device) {
-      SDL_ReleaseGPUGraphicsPipeline(m_device, m_pipeline);
-      m_pipeline = nullptr;
-    }
+/*
+ * 管线状态描述，相同描述的管线只创建一次
+ */
+struct PipelineDesc {
+  std::string vert;
+  std::string frag;
+  ShaderConfig vert_config{.shader_stage = SDL_GPU_SHADERSTAGE_VERTEX};
+  ShaderConfig frag_config{.shader_stage = SDL_GPU_SHADERSTAGE_FRAGMENT};
+  BlendMode blend{BlendMode::Opaque};
+  SDL_GPUCullMode cull{SDL_GPU_CULLMODE_BACK};
+  VertexLayout layout{VertexLayout::Quad};
+  // INVALID表示使用交换链格式
+  SDL_GPUTextureFormat target_format{SDL_GPU_TEXTUREFORMAT_INVALID};
+
+  bool operator==(const PipelineDesc &) const = default;
+
+  uint64_t hash() const {
+    uint64_t h = hashValue(std::string_view{vert}, 14695981039346656037ull);
+    h = hashValue(std::string_view{frag}, h);
+    h = hashValue(vert_config, h);
+    h = hashValue(frag_config, h);
+    h = hashValue(blend, h);
+    h = hashValue(cull, h);
+    h = hashValue(layout, h);
+    return hashValue(target_format, h);
   }
+};
 
-  virtual void init(const std::filesystem::path &vert,
-                    const std::filesystem::path &frag) = 0;
+struct SamplerDesc {
+  SDL_GPUFilter min_filter{SDL_GPU_FILTER_NEAREST};
+  SDL_GPUFilter mag_filter{SDL_GPU_FILTER_NEAREST};
+  SDL_GPUSamplerMipmapMode mipmap_mode{SDL_GPU_SAMPLERMIPMAPMODE_NEAREST};
+  SDL_GPUSamplerAddressMode address_u{SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE};
+  SDL_GPUSamplerAddressMode address_v{SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE};
 
-  SDL_GPUGraphicsPipeline *get() const { return m_pipeline; }
+  bool operator==(const SamplerDesc &) const = default;
 
-  BasePipeline(BasePipeline &) = delete;
-  BasePipeline(BasePipeline &&) = delete;
-  BasePipeline &operator=(BasePipeline &) = delete;
-  BasePipeline &operator=(BasePipeline &&) = delete;
+  uint64_t hash() const {
+    uint64_t h = hashValue(min_filter, 14695981039346656037ull);
+    h = hashValue(mag_filter, h);
+    h = hashValue(mipmap_mode, h);
+    h = hashValue(address_u, h);
+    return hashValue(address_v, h);
+  }
+};
+
+struct DescHash {
+  template <typename T> size_t operator()(const T &desc) const {
+    return static_cast<size_t>(desc.hash());
+  }
 };
 
 } // namespace engine::render
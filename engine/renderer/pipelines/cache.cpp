@@ -0,0 +1,335 @@
+#include "cache.hpp"
+#include "../../core/thread_pool.hpp"
+#include "../../resource_manager/asset_pack.hpp"
+#include "spdlog/spdlog.h"
+#include <SDL3/SDL_error.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <array>
+#include <cstddef>
+#include <latch>
+
+namespace engine::render {
+
+namespace {
+SDL_GPUColorTargetBlendState blendState(BlendMode mode) {
+  SDL_GPUColorTargetBlendState state{};
+  switch (mode) {
+  case BlendMode::Opaque:
+    break;
+  case BlendMode::Alpha:
+    state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+    state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+    state.color_blend_op = SDL_GPU_BLENDOP_ADD;
+    state.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    state.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+    state.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+    state.enable_blend = true;
+    break;
+  case BlendMode::Additive:
+    state.src_color_blendfactor = SDL_GPU_BLENDFACTOR_SRC_ALPHA;
+    state.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    state.color_blend_op = SDL_GPU_BLENDOP_ADD;
+    state.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    state.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+    state.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+    state.enable_blend = true;
+    break;
+  }
+  return state;
+}
+} // namespace
+
+PipelineCache::PipelineCache(SDL_GPUDevice *device,
+                             SDL_GPUTextureFormat default_format,
+                             const engine::resource::AssetPack *pack)
+    : m_device{device}, m_default_format{default_format}, m_pack{pack} {
+  spdlog::trace("管线缓存初始化");
+}
+
+PipelineCache::~PipelineCache() {
+  for (auto &pipeline : m_pipelines) {
+    if (pipeline.pipeline) {
+      SDL_ReleaseGPUGraphicsPipeline(m_device, pipeline.pipeline);
+    }
+  }
+  for (auto &[key, shader] : m_shaders) {
+    SDL_ReleaseGPUShader(m_device, shader);
+  }
+  for (auto &[desc, sampler] : m_samplers) {
+    SDL_ReleaseGPUSampler(m_device, sampler);
+  }
+  spdlog::trace("管线缓存退出");
+}
+
+PipelineDesc PipelineCache::normalize(const PipelineDesc &desc) const {
+  PipelineDesc ret = desc;
+  if (ret.target_format == SDL_GPU_TEXTUREFORMAT_INVALID) {
+    ret.target_format = m_default_format;
+  }
+  return ret;
+}
+
+SDL_GPUShader *PipelineCache::shader(const std::string &path,
+                                     const ShaderConfig &config) {
+  ShaderKey key{.path = path, .config = config};
+  if (auto it = m_shaders.find(key); it != m_shaders.end()) {
+    return it->second;
+  }
+
+  auto code = m_code.find(path);
+  std::vector<uint8_t> packed;
+  if (code == m_code.end() && m_pack && m_pack->read(path, packed)) {
+    code = m_code.emplace(path, std::move(packed)).first;
+    m_stats.shader_loads++;
+  }
+  if (code == m_code.end()) {
+    size_t code_size;
+    void *data = SDL_LoadFile(path.data(), &code_size);
+    if (!data) {
+      spdlog::error("加载shader文件 {}失败 {}", path, SDL_GetError());
+      return nullptr;
+    }
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    code = m_code.emplace(path, std::vector<uint8_t>(bytes, bytes + code_size))
+               .first;
+    SDL_free(data);
+    m_stats.shader_loads++;
+  }
+
+  SDL_GPUShaderCreateInfo create_info{
+      .code_size = code->second.size(),
+      .code = code->second.data(),
+      .entrypoint = "main",
+      .format = SDL_GPU_SHADERFORMAT_SPIRV, // 只考虑用spirv
+      .stage = config.shader_stage,
+      .num_samplers = config.sample_count,
+      .num_storage_textures = config.storage_texture_count,
+      .num_storage_buffers = config.storage_buff_count,
+      .num_uniform_buffers = config.uniform_buff_count,
+      .props = 0,
+  };
+  SDL_GPUShader *ret = SDL_CreateGPUShader(m_device, &create_info);
+  if (!ret) {
+    spdlog::error("创建shader {}失败 {}", path, SDL_GetError());
+    return nullptr;
+  }
+  m_shaders.emplace(std::move(key), ret);
+  m_stats.shaders++;
+  return ret;
+}
+
+std::optional<uint8_t> PipelineCache::reserve(const PipelineDesc &desc,
+                                              bool &created) {
+  created = false;
+  if (auto it = m_ids.find(desc); it != m_ids.end()) {
+    m_stats.hits++;
+    return it->second;
+  }
+  if (m_pipelines.size() > UINT8_MAX && m_free_ids.empty()) {
+    spdlog::error("管线数量超过上限");
+    return std::nullopt;
+  }
+  if (!shader(desc.vert, desc.vert_config) ||
+      !shader(desc.frag, desc.frag_config)) {
+    spdlog::error("创建shader失败");
+    return std::nullopt;
+  }
+  uint8_t id = 0;
+  if (!m_free_ids.empty()) {
+    id = m_free_ids.back();
+    m_free_ids.pop_back();
+    m_pipelines[id] = Pipeline{.desc = desc};
+  } else {
+    id = static_cast<uint8_t>(m_pipelines.size());
+    m_pipelines.push_back(Pipeline{.desc = desc});
+  }
+  m_ids.emplace(desc, id);
+  m_stats.pipelines++;
+  m_stats.misses++;
+  created = true;
+  return id;
+}
+
+void PipelineCache::forget(uint8_t id) {
+  m_ids.erase(m_pipelines[id].desc);
+  m_pipelines[id] = Pipeline{};
+  m_free_ids.push_back(id);
+  m_stats.pipelines--;
+}
+
+SDL_GPUGraphicsPipeline *
+PipelineCache::build(const PipelineDesc &desc) const {
+  SDL_GPUShader *vert_shader =
+      m_shaders.at(ShaderKey{.path = desc.vert, .config = desc.vert_config});
+  SDL_GPUShader *frag_shader =
+      m_shaders.at(ShaderKey{.path = desc.frag, .config = desc.frag_config});
+
+  SDL_GPUColorTargetDescription color_target_desc{
+      .format = desc.target_format,
+      .blend_state = blendState(desc.blend),
+  };
+
+  std::array<SDL_GPUVertexAttribute, 2> vattribute{};
+  vattribute[0].buffer_slot = 0;
+  vattribute[0].location = 0;
+  vattribute[0].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
+  vattribute[0].offset = offsetof(VertexInput, vertex_pos);
+
+  vattribute[1].buffer_slot = 0;
+  vattribute[1].location = 1;
+  vattribute[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
+  vattribute[1].offset = offsetof(VertexInput, texture_coord);
+
+  SDL_GPUVertexBufferDescription vdescription{
+      .slot = 0,
+      .pitch = sizeof(VertexInput),
+      .input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX,
+      .instance_step_rate = 0,
+  };
+  SDL_GPUGraphicsPipelineCreateInfo create_info{
+      .vertex_shader = vert_shader,
+      .fragment_shader = frag_shader,
+      .vertex_input_state =
+          {
+              .vertex_buffer_descriptions = &vdescription,
+              .num_vertex_buffers = 1,
+              .vertex_attributes = vattribute.data(),
+              .num_vertex_attributes =
+                  static_cast<uint32_t>(vattribute.size()),
+          },
+      .primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST,
+      .rasterizer_state =
+          {
+              .fill_mode = SDL_GPU_FILLMODE_FILL,
+              .cull_mode = desc.cull,
+              .front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE,
+              .depth_bias_constant_factor = 0.0f,
+              .depth_bias_clamp = 0.0f,
+              .depth_bias_slope_factor = 0.0f,
+              .enable_depth_bias = false,
+              .enable_depth_clip = false,
+              .padding1 = 0,
+              .padding2 = 0,
+          },
+      .multisample_state =
+          {
+              .sample_count = SDL_GPU_SAMPLECOUNT_1,
+              .sample_mask = 0,
+              .enable_mask = false,
+              .enable_alpha_to_coverage = false,
+              .padding2 = 0,
+              .padding3 = 0,
+          },
+      .depth_stencil_state = {},
+      .target_info =
+          {
+              .color_target_descriptions = &color_target_desc,
+              .num_color_targets = 1,
+              .depth_stencil_format = SDL_GPU_TEXTUREFORMAT_INVALID,
+              .has_depth_stencil_target = false,
+              .padding1 = 0,
+              .padding2 = 0,
+              .padding3 = 0,
+          },
+      .props = 0,
+  };
+  SDL_GPUGraphicsPipeline *pipeline =
+      SDL_CreateGPUGraphicsPipeline(m_device, &create_info);
+  if (!pipeline) {
+    spdlog::error("创建管线{}+{}失败 {}", desc.vert, desc.frag,
+                  SDL_GetError());
+  }
+  return pipeline;
+}
+
+std::optional<uint8_t> PipelineCache::get(const PipelineDesc &desc) {
+  PipelineDesc normalized = normalize(desc);
+  bool created = false;
+  auto id = reserve(normalized, created);
+  if (id && created) {
+    m_pipelines[*id].pipeline = build(normalized);
+    if (!m_pipelines[*id].pipeline) {
+      forget(*id);
+      return std::nullopt;
+    }
+  }
+  return id;
+}
+
+void PipelineCache::prepare(const std::vector<PipelineDesc> &descs,
+                            engine::core::ThreadPool *pool) {
+  uint64_t start = SDL_GetTicksNS();
+  // shader的读取和创建在主线程完成，工作线程只读缓存
+  std::vector<uint8_t> ids;
+  for (const auto &desc : descs) {
+    bool created = false;
+    if (auto id = reserve(normalize(desc), created); id && created) {
+      ids.push_back(*id);
+    }
+  }
+
+  if (pool && ids.size() > 1) {
+    std::latch done{static_cast<std::ptrdiff_t>(ids.size())};
+    for (uint8_t id : ids) {
+      pool->submit([this, id, &done] {
+        // 每个任务只写自己的槽位
+        m_pipelines[id].pipeline = build(m_pipelines[id].desc);
+        done.count_down();
+      });
+    }
+    done.wait();
+  } else {
+    for (uint8_t id : ids) {
+      m_pipelines[id].pipeline = build(m_pipelines[id].desc);
+    }
+  }
+  // 工作线程全部结束后才修改登记表
+  uint32_t failed = 0;
+  for (uint8_t id : ids) {
+    if (!m_pipelines[id].pipeline) {
+      forget(id);
+      failed++;
+    }
+  }
+  if (failed > 0) {
+    spdlog::error("预创建管线失败{}个", failed);
+  }
+  spdlog::debug("预创建管线{}个，耗时{}us", ids.size(),
+                (SDL_GetTicksNS() - start) / 1000);
+}
+
+SDL_GPUSampler *PipelineCache::sampler(const SamplerDesc &desc) {
+  if (auto it = m_samplers.find(desc); it != m_samplers.end()) {
+    return it->second;
+  }
+  SDL_GPUSamplerCreateInfo create_info{
+      .min_filter = desc.min_filter,
+      .mag_filter = desc.mag_filter,
+      .mipmap_mode = desc.mipmap_mode,
+      .address_mode_u = desc.address_u,
+      .address_mode_v = desc.address_v,
+      .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
+      .mip_lod_bias = 0.0f,
+      .max_anisotropy = 0.0f,
+      .compare_op = SDL_GPU_COMPAREOP_GREATER_OR_EQUAL,
+      .min_lod = 0.0f,
+      .max_lod = 0.0f,
+      .enable_anisotropy = false,
+      .enable_compare = false,
+      .padding1 = 0,
+      .padding2 = 0,
+      .props = 0,
+  };
+  SDL_GPUSampler *ret = SDL_CreateGPUSampler(m_device, &create_info);
+  if (!ret) {
+    spdlog::error("创建采样器失败 {}", SDL_GetError());
+    return nullptr;
+  }
+  m_samplers.emplace(desc, ret);
+  m_stats.samplers++;
+  return ret;
+}
+
+} // namespace engine::render
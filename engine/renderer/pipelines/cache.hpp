@@ -0,0 +1,104 @@
+#pragma once
+
+#include "base.hpp"
+#include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_video.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine::core {
+class ThreadPool;
+}
+
+namespace engine::resource {
+class AssetPack;
+}
+
+namespace engine::render {
+
+struct PipelineCacheStats {
+  uint32_t pipelines{0};
+  uint32_t shaders{0};
+  uint32_t samplers{0};
+  // 从磁盘读取spirv的次数
+  uint32_t shader_loads{0};
+  uint32_t hits{0};
+  uint32_t misses{0};
+};
+
+/*
+ * 管线、shader和采样器缓存
+ * 管线按状态描述的哈希查找，id用于排序键，最多256个
+ * shader文件每个路径只读取一次，相同配置的shader模块共享
+ */
+class PipelineCache final {
+private:
+  struct ShaderKey {
+    std::string path;
+    ShaderConfig config;
+
+    bool operator==(const ShaderKey &) const = default;
+    uint64_t hash() const {
+      return hashValue(config, hashValue(std::string_view{path},
+                                         14695981039346656037ull));
+    }
+  };
+  struct Pipeline {
+    PipelineDesc desc;
+    SDL_GPUGraphicsPipeline *pipeline{nullptr};
+  };
+
+  SDL_GPUDevice *m_device{nullptr};
+  SDL_GPUTextureFormat m_default_format{SDL_GPU_TEXTUREFORMAT_INVALID};
+  // 不为空时优先从资源包读取spirv
+  const engine::resource::AssetPack *m_pack{nullptr};
+
+  std::unordered_map<std::string, std::vector<uint8_t>> m_code;
+  std::unordered_map<ShaderKey, SDL_GPUShader *, DescHash> m_shaders;
+  std::unordered_map<PipelineDesc, uint8_t, DescHash> m_ids;
+  // 按id索引
+  std::vector<Pipeline> m_pipelines;
+  // 创建失败后空出来的id
+  std::vector<uint8_t> m_free_ids;
+  std::unordered_map<SamplerDesc, SDL_GPUSampler *, DescHash> m_samplers;
+  PipelineCacheStats m_stats;
+
+private:
+  // 目标格式为INVALID时换成交换链格式
+  PipelineDesc normalize(const PipelineDesc &desc) const;
+  SDL_GPUShader *shader(const std::string &path, const ShaderConfig &config);
+  // 登记描述并准备好shader，返回id和是否需要创建
+  std::optional<uint8_t> reserve(const PipelineDesc &desc, bool &created);
+  // 创建失败时移除登记，下次get重新尝试
+  void forget(uint8_t id);
+  // 只读访问缓存的shader，可以在工作线程调用
+  SDL_GPUGraphicsPipeline *build(const PipelineDesc &desc) const;
+
+public:
+  PipelineCache(SDL_GPUDevice *device, SDL_GPUTextureFormat default_format,
+                const engine::resource::AssetPack *pack = nullptr);
+  ~PipelineCache();
+
+  // 获取或创建管线，返回管线id，创建失败返回空
+  std::optional<uint8_t> get(const PipelineDesc &desc);
+  // 启动时批量创建，pool不为空时并行创建管线
+  void prepare(const std::vector<PipelineDesc> &descs,
+               engine::core::ThreadPool *pool = nullptr);
+  SDL_GPUGraphicsPipeline *at(uint8_t id) const {
+    return id < m_pipelines.size() ? m_pipelines[id].pipeline : nullptr;
+  }
+
+  SDL_GPUSampler *sampler(const SamplerDesc &desc);
+
+  const PipelineCacheStats &getStats() const { return m_stats; }
+
+  PipelineCache(PipelineCache &) = delete;
+  PipelineCache(PipelineCache &&) = delete;
+  PipelineCache &operator=(PipelineCache &) = delete;
+  PipelineCache &operator=(PipelineCache &&) = delete;
+};
+
+} // namespace engine::render
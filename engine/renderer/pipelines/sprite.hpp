@@ -0,0 +1,24 @@
+#pragma once
+
+#include "base.hpp"
+
+namespace engine::render {
+
+/*
+ * 实例化精灵管线
+ * 顶点着色器从storage buffer按gl_InstanceIndex读取TileInfo
+ */
+inline PipelineDesc spritePipelineDesc(BlendMode blend = BlendMode::Opaque) {
+  return PipelineDesc{
+      .vert = "../shaders/tile/instanced_vert.spv",
+      .frag = "../shaders/tile/frag.spv",
+      .vert_config = {.uniform_buff_count = 1,
+                      .storage_buff_count = 1,
+                      .shader_stage = SDL_GPU_SHADERSTAGE_VERTEX},
+      .frag_config = {.sample_count = 1,
+                      .shader_stage = SDL_GPU_SHADERSTAGE_FRAGMENT},
+      .blend = blend,
+  };
+}
+
+} // namespace engine::render
@@ -1,22 +1,28 @@
 #pragma once
 
 #include "SDL3_image/SDL_image.h"
-#include "pipelines/tile.hpp"
+#include "../core/pool.hpp"
+#include "../core/profiler.hpp"
+#include "camera.hpp"
+#include "pipelines/cache.hpp"
+#include "pipelines/sprite.hpp"
 #include "spdlog/spdlog.h"
+#include "sprite_batch.hpp"
 #include "tile.hpp"
+#include "upload_ring.hpp"
 #include <SDL3/SDL_error.h>
 #include <SDL3/SDL_gpu.h>
 #include <SDL3/SDL_render.h>
 #include <SDL3/SDL_surface.h>
 #include <SDL3/SDL_video.h>
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 #include <glm/ext/vector_int2.hpp>
 #include <memory>
+#include <optional>
 #include <string_view>
-#include <type_traits>
-#include <typeindex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -27,12 +33,52 @@ template <typename T> class RenderObject;
 
 struct RenderContext {
   SDL_GPUCommandBuffer *cmd;
-  SDL_GPUTexture *swapchain_texture;
+  // 本帧的渲染目标，交换链图像或离屏贴图
+  SDL_GPUTexture *target;
   SDL_GPURenderPass *render_pass;
 };
 
+struct RendererConfig {
+  uint32_t width{1024};
+  uint32_t height{720};
+  // 不创建窗口，渲染到离屏贴图，没有显示器时可以用软件vulkan驱动运行
+  bool headless{false};
+  // 不为空时shader优先从资源包读取
+  const engine::resource::AssetPack *pack{nullptr};
+};
+
+// 每帧渲染统计
+struct RenderStats {
+  uint32_t draw_calls{0};
+  uint32_t sprites{0};
+  uint32_t pipeline_binds{0};
+  uint32_t texture_binds{0};
+  uint32_t buffer_binds{0};
+  uint64_t uniform_bytes{0};
+  // 状态没有变化而跳过的调用
+  uint32_t skipped_calls{0};
+  // 场景相机剔除的结果
+  uint32_t visible{0};
+  uint32_t culled{0};
+  uint64_t sort_time_ns{0};
+  uint64_t upload_bytes{0};
+  uint32_t upload_stalls{0};
+};
+
 class Renderer final {
 private:
+  // 当前render pass中已绑定的状态，新的render pass开始时失效
+  struct BoundState {
+    SDL_GPUGraphicsPipeline *pipeline{nullptr};
+    SDL_GPUBuffer *vertex_buffer{nullptr};
+    SDL_GPUBuffer *index_buffer{nullptr};
+    SDL_GPUBuffer *storage_buffer{nullptr};
+    SDL_GPUTexture *texture{nullptr};
+    SDL_GPUSampler *sampler{nullptr};
+  };
+  // 每个shader阶段最多4个uniform槽位
+  static constexpr uint32_t kUniformSlots = 4;
+
   struct DeviceDeleter {
     void operator()(SDL_GPUDevice *device) {
       if (device) {
@@ -53,28 +99,67 @@ private:
   };
   std::unique_ptr<SDL_Window, WindowDelter> m_window;
 
-  RenderContext m_context;
-
-  std::unordered_map<std::type_index, std::unique_ptr<BasePipeline>>
-      m_pipelines;
+  RenderContext m_context{};
+  // 无窗口模式的渲染目标
+  SDL_GPUTexture *m_offscreen{nullptr};
+  // 回读最后一帧用的下载buffer
+  SDL_GPUTransferBuffer *m_readback{nullptr};
+  uint32_t m_readback_size{0};
+  // captureFrame()之后的end()中下载渲染结果
+  bool m_capture{false};
+  bool m_captured{false};
+
+  // 排序键中只存管线id
+  std::unique_ptr<PipelineCache> m_pipeline_cache;
+  // 按BlendMode索引的精灵管线id
+  std::array<uint8_t, 3> m_sprite_pipelines{};
+
+  struct TextureSlot {
+    // 贴图id，0表示未知
+    uint16_t id{0};
+    // 最后一次绑定(或创建)时的帧号，资源管理器按它驱逐冷贴图
+    uint64_t last_bound{0};
+  };
+  std::unordered_map<SDL_GPUTexture *, TextureSlot> m_texture_ids;
+  std::vector<uint16_t> m_free_texture_ids;
+  uint16_t m_next_texture_id{1};
+  // 每次begin()加一
+  uint64_t m_frame_index{0};
 
   // 2d 渲染
   SDL_GPUBuffer *m_vertex_buffer{nullptr};
   SDL_GPUBuffer *m_index_buffer{nullptr};
+  // 默认采样器，由管线缓存持有
   SDL_GPUSampler *m_sampler{nullptr};
 
+  std::unique_ptr<UploadRing> m_upload_ring;
+  // 帧开始时的上传统计，用于计算本帧增量
+  UploadStats m_upload_base;
+  std::unique_ptr<SpriteBatch> m_sprite_batch;
+  SDL_FColor m_clear_color{0.0f, 0.0f, 0.0f, 1.0f};
+  // 本帧是否已经清屏，之后的render pass需要保留内容
+  bool m_cleared{false};
+  RenderStats m_stats;
+  RenderStats m_last_stats;
+  BoundState m_bound;
+  // 每个槽位最后一次推送的数据，uniform在整个command buffer内有效
+  std::array<std::vector<uint8_t>, kUniformSlots> m_vertex_uniforms;
+  // 每帧开始时读取一次
+  glm::vec2 m_window_size{0.0f, 0.0f};
+  Camera m_camera;
+  // 固定步长模拟的插值系数，每帧渲染前设置
+  float m_interpolation{1.0f};
+  // tile在对象创建和销毁时频繁分配，必须比所有场景活得久
+  engine::core::Pool<Tile> m_tile_pool;
+
 private:
   template <typename T>
   [[nodiscard]] SDL_GPUBuffer *createBuff(const std::vector<T> &datas,
                                           SDL_GPUBufferUsageFlags usage) {
+    uint32_t size = static_cast<uint32_t>(sizeof(T) * datas.size());
     SDL_GPUBufferCreateInfo vbuff_info{
         .usage = usage,
-        .size = static_cast<uint32_t>(sizeof(T) * datas.size()),
-        .props = 0,
-    };
-    SDL_GPUTransferBufferCreateInfo tbuff_info{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = static_cast<uint32_t>(sizeof(T) * datas.size()),
+        .size = size,
         .props = 0,
     };
     SDL_GPUBuffer *buff = SDL_CreateGPUBuffer(m_device.get(), &vbuff_info);
@@ -82,41 +167,12 @@ private:
       spdlog::error("创建vertex buff失败");
       return nullptr;
     }
-    SDL_GPUTransferBuffer *tbuff =
-        SDL_CreateGPUTransferBuffer(m_device.get(), &tbuff_info);
-    if (!tbuff) {
-      spdlog::error("创建transfer buff失败");
-      return nullptr;
-    }
-
-    void *data = SDL_MapGPUTransferBuffer(m_device.get(), tbuff, false);
-    std::memcpy(data, datas.data(), sizeof(T) * datas.size());
-    SDL_UnmapGPUTransferBuffer(m_device.get(), tbuff);
-
-    SDL_GPUCommandBuffer *cmd = SDL_AcquireGPUCommandBuffer(m_device.get());
-    if (!cmd) {
-      spdlog::error("请求command buffer失败");
-      return nullptr;
-    }
-    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
-    if (!cp) {
-      spdlog::error("begin copy pass失败");
+    // 写入上传环，下一次copy pass时上传
+    if (!m_upload_ring->uploadBuffer(buff, 0, datas.data(), size)) {
+      spdlog::error("上传buff数据失败");
+      SDL_ReleaseGPUBuffer(m_device.get(), buff);
       return nullptr;
     }
-
-    SDL_GPUTransferBufferLocation tbl{
-        .transfer_buffer = tbuff,
-        .offset = 0,
-    };
-    SDL_GPUBufferRegion br{
-        .buffer = buff,
-        .offset = 0,
-        .size = static_cast<uint32_t>(sizeof(T) * datas.size()),
-    };
-    SDL_UploadToGPUBuffer(cp, &tbl, &br, false);
-    SDL_EndGPUCopyPass(cp);
-    SDL_SubmitGPUCommandBuffer(cmd);
-    SDL_ReleaseGPUTransferBuffer(m_device.get(), tbuff);
     return buff;
   }
 
@@ -127,69 +183,222 @@ private:
     }
   }
 
-  // TODO 定制采样器
-  [[nodiscard]] SDL_GPUSampler *createSampler() {
-    SDL_GPUSamplerCreateInfo sampler_create_info{
-        .min_filter = SDL_GPU_FILTER_NEAREST,
-        .mag_filter = SDL_GPU_FILTER_NEAREST,
-        .mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST,
-        .address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-        .address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-        .address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE,
-        .mip_lod_bias = 0.0f,
-        .max_anisotropy = 0.0f,
-        .compare_op = SDL_GPU_COMPAREOP_GREATER_OR_EQUAL,
-        .min_lod = 0.0f,
-        .max_lod = 0.0f,
-        .enable_anisotropy = false,
-        .enable_compare = false,
+public:
+  // 顶点阶段可读的storage buffer，存放TileInfo之类的实例数据
+  [[nodiscard]] SDL_GPUBuffer *createStorageBuffer(uint32_t size) {
+    SDL_GPUBufferCreateInfo buff_info{
+        .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+        .size = size,
+        .props = 0,
+    };
+    SDL_GPUBuffer *buff = SDL_CreateGPUBuffer(m_device.get(), &buff_info);
+    if (!buff) {
+      spdlog::error("创建storage buff失败{}", SDL_GetError());
+    }
+    return buff;
+  }
+
+  void destroyBuffer(SDL_GPUBuffer *buff) { destroyBuff(buff); }
+
+  // 写入上传环，本帧的copy pass中上传
+  // buffer可能还在被之前的帧使用时cycle为true
+  bool uploadBuffer(SDL_GPUBuffer *buff, const void *data, uint32_t size,
+                    uint32_t offset = 0, bool cycle = true) {
+    return m_upload_ring->uploadBuffer(buff, offset, data, size, cycle);
+  }
+
+private:
+
+  // render pass按需开启，copy pass不能在render pass中进行
+  bool beginRenderPass() {
+    if (m_context.render_pass) {
+      return true;
+    }
+    if (!m_context.cmd || !m_context.target) {
+      return false;
+    }
+    // 开始render pass之前把待上传的数据记录到copy pass
+    m_upload_ring->record(m_context.cmd);
+    SDL_GPUColorTargetInfo info{
+        .texture = m_context.target,
+        .mip_level = 0,
+        .layer_or_depth_plane = 0,
+        .clear_color = m_clear_color,
+        .load_op = m_cleared ? SDL_GPU_LOADOP_LOAD : SDL_GPU_LOADOP_CLEAR,
+        .store_op = SDL_GPU_STOREOP_STORE,
+        .resolve_texture = nullptr,
+        .resolve_mip_level = 0,
+        .resolve_layer = 0,
+        .cycle = false,
+        .cycle_resolve_texture = false,
         .padding1 = 0,
         .padding2 = 0,
+    };
+    m_context.render_pass =
+        SDL_BeginGPURenderPass(m_context.cmd, &info, 1, nullptr);
+    if (!m_context.render_pass) {
+      spdlog::error("render失败{}", SDL_GetError());
+      return false;
+    }
+    m_cleared = true;
+    m_bound = {};
+    return true;
+  }
+
+  void endRenderPass() {
+    if (m_context.render_pass) {
+      SDL_EndGPURenderPass(m_context.render_pass);
+      m_context.render_pass = nullptr;
+    }
+  }
+
+  [[nodiscard]] SDL_GPUTexture *createOffscreen(uint32_t w, uint32_t h) {
+    SDL_GPUTextureCreateInfo create_info{
+        .type = SDL_GPU_TEXTURETYPE_2D,
+        .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
+        .usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET |
+                 SDL_GPU_TEXTUREUSAGE_SAMPLER,
+        .width = w,
+        .height = h,
+        .layer_count_or_depth = 1,
+        .num_levels = 1,
+        .sample_count = SDL_GPU_SAMPLECOUNT_1,
         .props = 0,
     };
-    SDL_GPUSampler *sampler =
-        SDL_CreateGPUSampler(m_device.get(), &sampler_create_info);
-    return sampler;
+    SDL_GPUTexture *texture =
+        SDL_CreateGPUTexture(m_device.get(), &create_info);
+    if (!texture) {
+      spdlog::error("创建离屏贴图失败 {}", SDL_GetError());
+    }
+    return texture;
+  }
+
+  // 在render pass结束后把离屏贴图下载到回读buffer
+  void recordReadback() {
+    auto w = static_cast<uint32_t>(m_window_size.x);
+    auto h = static_cast<uint32_t>(m_window_size.y);
+    uint32_t size = w * h * 4;
+    if (m_readback_size < size) {
+      if (m_readback) {
+        SDL_ReleaseGPUTransferBuffer(m_device.get(), m_readback);
+      }
+      SDL_GPUTransferBufferCreateInfo info{
+          .usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD,
+          .size = size,
+          .props = 0,
+      };
+      m_readback = SDL_CreateGPUTransferBuffer(m_device.get(), &info);
+      m_readback_size = m_readback ? size : 0;
+      if (!m_readback) {
+        spdlog::error("创建回读buffer失败{}", SDL_GetError());
+        return;
+      }
+    }
+    SDL_GPUCopyPass *pass = SDL_BeginGPUCopyPass(m_context.cmd);
+    if (!pass) {
+      spdlog::error("开始回读copy pass失败{}", SDL_GetError());
+      return;
+    }
+    SDL_GPUTextureRegion src{
+        .texture = m_offscreen,
+        .mip_level = 0,
+        .layer = 0,
+        .x = 0,
+        .y = 0,
+        .z = 0,
+        .w = w,
+        .h = h,
+        .d = 1,
+    };
+    SDL_GPUTextureTransferInfo dst{
+        .transfer_buffer = m_readback,
+        .offset = 0,
+        .pixels_per_row = w,
+        .rows_per_layer = h,
+    };
+    SDL_DownloadFromGPUTexture(pass, &src, &dst);
+    SDL_EndGPUCopyPass(pass);
+    m_captured = true;
   }
 
-  void destroySampler(SDL_GPUSampler *sampler) {
-    if (sampler) {
-      SDL_ReleaseGPUSampler(m_device.get(), sampler);
-      sampler = nullptr;
+  // 上传本帧的精灵实例，只在排序键的管线/贴图边界处切换状态
+  void flushSprites() {
+    TRIAL_PROFILE_ZONE("Renderer::flushSprites");
+    if (!m_sprite_batch || m_sprite_batch->empty()) {
+      return;
+    }
+    endRenderPass();
+    if (!m_sprite_batch->upload(*m_upload_ring) || !beginRenderPass()) {
+      m_sprite_batch->clear();
+      return;
+    }
+    m_stats.sort_time_ns += m_sprite_batch->getSortTime();
+    SDL_GPUBuffer *instance_buffer = m_sprite_batch->getInstanceBuffer();
+    RenderInfo rinfo{m_camera.getViewProjection()};
+    // 重复的绑定由状态缓存跳过
+    for (const auto &run : m_sprite_batch->getRuns()) {
+      if (!bindPipeline(run.pipeline)) {
+        continue;
+      }
+      bindStorageBuffer(run.buffer ? run.buffer : instance_buffer);
+      pushVertexUniform<RenderInfo>(rinfo, 0);
+      bindTexture(run.texture);
+      drawInstanced(run.count, run.first);
     }
+    m_stats.sprites += m_sprite_batch->size();
+    m_sprite_batch->clear();
   }
 
 public:
   Renderer() = default;
   ~Renderer() {
-    destroySampler(m_sampler);
+    m_sprite_batch.reset();
     destroyBuff(m_vertex_buffer);
     destroyBuff(m_index_buffer);
-    SDL_WaitForGPUSwapchain(m_device.get(), m_window.get());
+    if (m_window) {
+      SDL_WaitForGPUSwapchain(m_device.get(), m_window.get());
+    }
     SDL_WaitForGPUIdle(m_device.get());
-    m_pipelines.clear();
-    SDL_ReleaseWindowFromGPUDevice(m_device.get(), m_window.get());
+    m_upload_ring.reset();
+    m_pipeline_cache.reset();
+    if (m_readback) {
+      SDL_ReleaseGPUTransferBuffer(m_device.get(), m_readback);
+    }
+    if (m_offscreen) {
+      SDL_ReleaseGPUTexture(m_device.get(), m_offscreen);
+    }
+    if (m_window) {
+      SDL_ReleaseWindowFromGPUDevice(m_device.get(), m_window.get());
+    }
     m_window.reset();
     m_device.reset();
   }
 
-  [[nodiscard]] SDL_GPUTexture *createTexture(std::string_view path) {
+  // 加载图片并转换到rgba格式，调用者负责销毁
+  // 不访问渲染器状态，可以在工作线程调用
+  [[nodiscard]] static SDL_Surface *loadSurface(std::string_view path) {
     SDL_Surface *surface = IMG_Load(path.data());
     if (!surface) {
-      spdlog::error("create texture失败 {}", SDL_GetError());
+      spdlog::error("加载图片失败 {}", SDL_GetError());
       return nullptr;
     }
-    // 转换到rgba格式
     SDL_Surface *usurface =
         SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ABGR8888);
     SDL_DestroySurface(surface);
+    if (!usurface) {
+      spdlog::error("转换图片格式失败 {}", SDL_GetError());
+    }
+    return usurface;
+  }
 
+  // 创建空的rgba贴图
+  [[nodiscard]] SDL_GPUTexture *createTexture(uint32_t w, uint32_t h) {
     SDL_GPUTextureCreateInfo create_info{
         .type = SDL_GPU_TEXTURETYPE_2D,
         .format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM,
         .usage = SDL_GPU_TEXTUREUSAGE_SAMPLER,
-        .width = static_cast<uint32_t>(usurface->w),
-        .height = static_cast<uint32_t>(usurface->h),
+        .width = w,
+        .height = h,
         .layer_count_or_depth = 1,
         .num_levels = 1,
         .sample_count = SDL_GPU_SAMPLECOUNT_1,
@@ -198,138 +407,141 @@ public:
     SDL_GPUTexture *texture =
         SDL_CreateGPUTexture(m_device.get(), &create_info);
     if (!texture) {
-      SDL_DestroySurface(usurface);
       spdlog::error("create texture失败 {}", SDL_GetError());
       return nullptr;
     }
-
-    // 创建transfer buffer将surface数据拷贝到transfer buffer
-    SDL_GPUTransferBufferCreateInfo transfer_info{
-        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
-        .size = static_cast<uint32_t>(usurface->w * usurface->h * 4),
-        .props = 0,
-    };
-    SDL_GPUTransferBuffer *transfer_buff =
-        SDL_CreateGPUTransferBuffer(m_device.get(), &transfer_info);
-    if (!transfer_buff) {
-      SDL_ReleaseGPUTexture(m_device.get(), texture);
-      SDL_DestroySurface(usurface);
-      spdlog::error("create texture失败 {}", SDL_GetError());
-      return nullptr;
+    uint16_t id = 0;
+    if (!m_free_texture_ids.empty()) {
+      id = m_free_texture_ids.back();
+      m_free_texture_ids.pop_back();
+    } else if (m_next_texture_id != 0) {
+      // 溢出后为0，之后的贴图共享未知id
+      id = m_next_texture_id++;
     }
+    m_texture_ids.emplace(texture,
+                          TextureSlot{.id = id, .last_bound = m_frame_index});
+    return texture;
+  }
 
-    void *ptr = SDL_MapGPUTransferBuffer(m_device.get(), transfer_buff, false);
-    std::memcpy(ptr, usurface->pixels, usurface->w * usurface->h * 4);
-    SDL_UnmapGPUTransferBuffer(m_device.get(), transfer_buff);
+  // 将rgba surface上传到贴图的(x, y)处，本帧的copy pass中统一上传
+  bool uploadTexture(SDL_GPUTexture *texture, const SDL_Surface *surface,
+                     uint32_t x = 0, uint32_t y = 0) {
+    if (!texture || !surface) {
+      return false;
+    }
+    return m_upload_ring->uploadTexture(
+        texture, x, y, static_cast<uint32_t>(surface->w),
+        static_cast<uint32_t>(surface->h), surface->pixels,
+        static_cast<uint32_t>(surface->pitch));
+  }
 
-    SDL_GPUCommandBuffer *cmd = SDL_AcquireGPUCommandBuffer(m_device.get());
-    if (!cmd) {
-      SDL_ReleaseGPUTexture(m_device.get(), texture);
-      SDL_DestroySurface(usurface);
-      SDL_ReleaseGPUTransferBuffer(m_device.get(), transfer_buff);
+  [[nodiscard]] SDL_GPUTexture *createTexture(const SDL_Surface *surface) {
+    if (!surface) {
       return nullptr;
     }
-    SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
-    if (!cp) {
-      SDL_ReleaseGPUTexture(m_device.get(), texture);
-      SDL_DestroySurface(usurface);
-      SDL_ReleaseGPUTransferBuffer(m_device.get(), transfer_buff);
-      spdlog::error("create texture失败 {}", SDL_GetError());
+    SDL_GPUTexture *texture =
+        createTexture(static_cast<uint32_t>(surface->w),
+                      static_cast<uint32_t>(surface->h));
+    if (texture && !uploadTexture(texture, surface)) {
+      // 归还id，上传队列中也不能再引用这张贴图
+      destroyTexture(texture);
       return nullptr;
     }
+    return texture;
+  }
 
-    // 将transfer buffer中的数据拷贝到gpu texture
-    SDL_GPUTextureTransferInfo texture_transfer_info{
-        .transfer_buffer = transfer_buff,
-        .offset = 0,
-        .pixels_per_row = 0,
-        .rows_per_layer = 0,
-    };
-
-    SDL_GPUTextureRegion region{
-        .texture = texture,
-        .mip_level = 0,
-        .layer = 0,
-        .x = 0,
-        .y = 0,
-        .z = 0,
-        .w = static_cast<uint32_t>(usurface->w),
-        .h = static_cast<uint32_t>(usurface->h),
-        .d = 1,
-    };
-    SDL_UploadToGPUTexture(cp, &texture_transfer_info, &region, false);
-    SDL_EndGPUCopyPass(cp);
-    SDL_SubmitGPUCommandBuffer(cmd);
-    SDL_ReleaseGPUTransferBuffer(m_device.get(), transfer_buff);
-    SDL_DestroySurface(usurface);
+  [[nodiscard]] SDL_GPUTexture *createTexture(std::string_view path) {
+    SDL_Surface *surface = loadSurface(path);
+    if (!surface) {
+      return nullptr;
+    }
+    SDL_GPUTexture *texture = createTexture(surface);
+    SDL_DestroySurface(surface);
     return texture;
   }
 
   void destroyTexture(SDL_GPUTexture *texture) {
     if (texture) {
+      m_upload_ring->forget(texture);
+      if (auto it = m_texture_ids.find(texture); it != m_texture_ids.end()) {
+        if (it->second.id != 0) {
+          m_free_texture_ids.push_back(it->second.id);
+        }
+        m_texture_ids.erase(it);
+      }
       SDL_ReleaseGPUTexture(m_device.get(), texture);
       texture = nullptr;
     }
   }
 
+  uint16_t getTextureId(SDL_GPUTexture *texture) const {
+    auto it = m_texture_ids.find(texture);
+    return it != m_texture_ids.end() ? it->second.id : 0;
+  }
+
+  // 贴图最后一次被绑定的帧号，没有绑定过时是创建时的帧号
+  uint64_t getTextureLastBound(SDL_GPUTexture *texture) const {
+    auto it = m_texture_ids.find(texture);
+    return it != m_texture_ids.end() ? it->second.last_bound : 0;
+  }
+  uint64_t getFrameIndex() const { return m_frame_index; }
+
   /*********************** pipeline ***********************/
-  template <typename T>
-  T *addPipeline(const std::filesystem::path &vert,
-                 const std::filesystem::path &frag) {
-    static_assert(std::is_base_of<BasePipeline, T>::value,
-                  "T类型必须继承自BasePipeline");
-    std::type_index ti{typeid(T)};
-    if (m_pipelines.contains(ti)) {
-      T *ret = static_cast<T *>(m_pipelines.find(ti)->second.get());
-      return ret;
-    }
-    auto new_pipeline = std::make_unique<T>(m_device.get(), m_window.get());
-    new_pipeline->init(vert, frag);
-    T *ptr = new_pipeline.get();
-    m_pipelines.emplace(ti, std::move(new_pipeline));
-    return ptr;
+  // 获取或创建管线，返回的id用于排序键和bindPipeline
+  std::optional<uint8_t> getPipeline(const PipelineDesc &desc) {
+    return m_pipeline_cache->get(desc);
   }
 
-  template <typename T> void removePipeline() {
-    static_assert(std::is_base_of<BasePipeline, T>::value,
-                  "T类型必须继承自BasePipeline");
-    std::type_index ti{typeid(T)};
-    auto it = m_pipelines.find(ti);
-    if (it != m_pipelines.end()) {
-      m_pipelines.erase(it);
-    }
+  SDL_GPUSampler *getSampler(const SamplerDesc &desc) {
+    return m_pipeline_cache->sampler(desc);
   }
 
-  template <typename T> T *getPipeline() {
-    static_assert(std::is_base_of<BasePipeline, T>::value,
-                  "T类型必须继承自BasePipeline");
-    std::type_index ti{typeid(T)};
-    if (m_pipelines.contains(ti)) {
-      return static_cast<T *>(m_pipelines.find(ti)->second.get());
-    }
-    return nullptr;
+  const PipelineCacheStats &getPipelineStats() const {
+    return m_pipeline_cache->getStats();
   }
 
   /*********************** renderer ***********************/
-  bool init() {
+  // pool不为空时并行创建启动时声明的管线
+  bool init(engine::core::ThreadPool *pool = nullptr,
+            const RendererConfig &config = {}) {
     auto *device = SDL_CreateGPUDevice(
         SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_DXIL, true, "vulkan");
     if (!device) {
       spdlog::error("创建gpu设备失败 {}", SDL_GetError());
       return false;
     }
-    // TODO 手动设置窗口大小
-    auto *window = SDL_CreateWindow("trial", 1024, 720, SDL_WINDOW_RESIZABLE);
-    if (!window) {
-      spdlog::error("创建SDL窗口失败{}", SDL_GetError());
-      return false;
-    }
-    if (!SDL_ClaimWindowForGPUDevice(device, window)) {
-      spdlog::error("窗口关联gpu失败{}", SDL_GetError());
-      return false;
-    }
-    m_window = std::unique_ptr<SDL_Window, WindowDelter>(window);
     m_device = std::unique_ptr<SDL_GPUDevice, DeviceDeleter>(device);
+    SDL_GPUTextureFormat target_format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    if (config.headless) {
+      m_offscreen = createOffscreen(config.width, config.height);
+      if (!m_offscreen) {
+        return false;
+      }
+      m_window_size = {static_cast<float>(config.width),
+                       static_cast<float>(config.height)};
+    } else {
+      auto *window =
+          SDL_CreateWindow("trial", static_cast<int>(config.width),
+                           static_cast<int>(config.height),
+                           SDL_WINDOW_RESIZABLE);
+      if (!window) {
+        spdlog::error("创建SDL窗口失败{}", SDL_GetError());
+        return false;
+      }
+      m_window = std::unique_ptr<SDL_Window, WindowDelter>(window);
+      if (!SDL_ClaimWindowForGPUDevice(device, window)) {
+        spdlog::error("窗口关联gpu失败{}", SDL_GetError());
+        return false;
+      }
+      target_format = SDL_GetGPUSwapchainTextureFormat(device, window);
+      int w, h;
+      SDL_GetWindowSize(window, &w, &h);
+      m_window_size = {static_cast<float>(w), static_cast<float>(h)};
+    }
+    // 默认相机让世界原点落在窗口左下角
+    m_camera.setViewport(m_window_size);
+    m_camera.setPosition(m_window_size * 0.5f);
+    m_upload_ring = std::make_unique<UploadRing>(m_device.get());
 
     std::vector<engine::render::VertexInput> vertex_datas{
         {{-1.0f, -1.0f}, {0.0f, 1.0f}},
@@ -343,20 +555,53 @@ public:
         vertex_datas, SDL_GPU_BUFFERUSAGE_VERTEX);
     m_index_buffer =
         createBuff<uint32_t>(index_datas, SDL_GPU_BUFFERUSAGE_INDEX);
-    m_sampler = createSampler();
-
-    // 瓦片渲染管线
-    addPipeline<TilePipeline>("../shaders/tile/vert.spv",
-                              "../shaders/tile/frag.spv");
+    m_pipeline_cache = std::make_unique<PipelineCache>(
+        m_device.get(), target_format, config.pack);
+    m_sampler = m_pipeline_cache->sampler(SamplerDesc{});
+    m_sprite_batch = std::make_unique<SpriteBatch>(m_device.get());
+
+    // 所有tile都经过精灵批次，只需要各混合模式的实例化精灵管线
+    m_pipeline_cache->prepare(
+        {
+            spritePipelineDesc(BlendMode::Opaque),
+            spritePipelineDesc(BlendMode::Alpha),
+            spritePipelineDesc(BlendMode::Additive),
+        },
+        pool);
+    for (auto blend :
+         {BlendMode::Opaque, BlendMode::Alpha, BlendMode::Additive}) {
+      auto id = m_pipeline_cache->get(spritePipelineDesc(blend));
+      if (!id || !m_pipeline_cache->at(*id)) {
+        spdlog::error("创建精灵管线失败{}", SDL_GetError());
+        return false;
+      }
+      m_sprite_pipelines[static_cast<size_t>(blend)] = *id;
+    }
     return true;
   }
 
   bool begin(float r = 0.0f, float g = 0.0f, float b = 0.0f, float a = 1.0f) {
+    TRIAL_PROFILE_ZONE("Renderer::begin");
+    m_frame_index++;
     m_context.cmd = nullptr;
-    m_context.swapchain_texture = nullptr;
+    m_context.target = nullptr;
     m_context.render_pass = nullptr;
-
-    if (!m_window) {
+    m_clear_color = {r, g, b, a};
+    m_cleared = false;
+    m_stats = {};
+    m_bound = {};
+    for (auto &uniform : m_vertex_uniforms) {
+      uniform.clear();
+    }
+    m_upload_ring->retire();
+    m_upload_base = m_upload_ring->getStats();
+
+    if (m_window) {
+      int w, h;
+      SDL_GetWindowSize(m_window.get(), &w, &h);
+      m_window_size = {static_cast<float>(w), static_cast<float>(h)};
+      m_camera.setViewport(m_window_size);
+    } else if (!m_offscreen) {
       return false;
     }
 
@@ -365,37 +610,26 @@ public:
       spdlog::error("请求命令失败{}", SDL_GetError());
       return false;
     }
+    // 离屏贴图不需要等待交换链
+    if (m_offscreen) {
+      m_context.target = m_offscreen;
+      return true;
+    }
 
     if (!SDL_WaitAndAcquireGPUSwapchainTexture(m_context.cmd, m_window.get(),
-                                               &m_context.swapchain_texture,
+                                               &m_context.target,
                                                nullptr, nullptr)) {
       spdlog::error("请求交换链图像失败{}", SDL_GetError());
+      SDL_CancelGPUCommandBuffer(m_context.cmd);
+      m_context.cmd = nullptr;
       return false;
     }
-    if (!m_context.swapchain_texture) {
-      spdlog::error("请求交换链图像失败2{}", SDL_GetError());
-      return false;
-    }
-
-    SDL_GPUColorTargetInfo info{
-        .texture = m_context.swapchain_texture,
-        .mip_level = 0,
-        .layer_or_depth_plane = 0,
-        .clear_color = {r, g, b, a},
-        .load_op = SDL_GPU_LOADOP_CLEAR,
-        .store_op = SDL_GPU_STOREOP_STORE,
-        .resolve_texture = nullptr,
-        .resolve_mip_level = 0,
-        .resolve_layer = 0,
-        .cycle = false,
-        .cycle_resolve_texture = false,
-        .padding1 = 0,
-        .padding2 = 0,
-    };
-    m_context.render_pass =
-        SDL_BeginGPURenderPass(m_context.cmd, &info, 1, nullptr);
-    if (!m_context.render_pass) {
-      spdlog::error("render失败{}", SDL_GetError());
+    if (!m_context.target) {
+      // 窗口最小化时没有交换链图像，命令仍需提交，顺便完成待上传的数据
+      m_upload_ring->record(m_context.cmd);
+      m_upload_ring->submitted(
+          SDL_SubmitGPUCommandBufferAndAcquireFence(m_context.cmd));
+      m_context.cmd = nullptr;
       return false;
     }
 
@@ -403,75 +637,250 @@ public:
   }
 
   void end() {
-    if (m_context.render_pass && m_context.cmd) {
-      SDL_EndGPURenderPass(m_context.render_pass);
-      SDL_SubmitGPUCommandBuffer(m_context.cmd);
-    }
-  }
-
-  template <typename T> bool bindPipeline() {
-    static_assert(std::is_base_of<BasePipeline, T>::value,
-                  "T类型必须继承自BasePipeline");
-    std::type_index ti{typeid(T)};
-    auto it = m_pipelines.find(ti);
-    if (it != m_pipelines.end() && it->second->get() && m_context.render_pass) {
-      SDL_BindGPUGraphicsPipeline(m_context.render_pass, it->second->get());
-      // bind vertex input
-      if (m_vertex_buffer) {
-        SDL_GPUBufferBinding vbind{
-            .buffer = m_vertex_buffer,
-            .offset = 0,
-        };
-        SDL_BindGPUVertexBuffers(m_context.render_pass, 0, &vbind, 1);
+    TRIAL_PROFILE_ZONE("Renderer::end");
+    if (m_context.cmd) {
+      flushSprites();
+      // 本帧没有任何绘制也要清屏
+      if (!m_cleared) {
+        beginRenderPass();
       }
-      if (m_index_buffer) {
-        SDL_GPUBufferBinding ibind{
-            .buffer = m_index_buffer,
-            .offset = 0,
-        };
-        SDL_BindGPUIndexBuffer(m_context.render_pass, &ibind,
-                               SDL_GPU_INDEXELEMENTSIZE_32BIT);
+      endRenderPass();
+      if (m_capture && m_offscreen) {
+        recordReadback();
       }
-      return true;
+      m_capture = false;
+      m_upload_ring->submitted(
+          SDL_SubmitGPUCommandBufferAndAcquireFence(m_context.cmd));
+      m_context.cmd = nullptr;
     }
-    return false;
+    const UploadStats &upload = m_upload_ring->getStats();
+    m_stats.upload_bytes = upload.bytes - m_upload_base.bytes;
+    m_stats.upload_stalls = upload.stalls - m_upload_base.stalls;
+    m_last_stats = m_stats;
   }
 
-  template <typename T> void pushVertexUniform(const T &val) {
-    if (m_context.cmd) {
-      SDL_PushGPUVertexUniformData(m_context.cmd, 0, &val, sizeof(T));
+  bool isHeadless() const { return m_offscreen != nullptr; }
+
+  // 下一次end()时回读渲染结果，只支持无窗口模式
+  void captureFrame() { m_capture = true; }
+
+  // 等待gpu完成后取出回读的rgba像素，行间没有填充
+  bool readPixels(std::vector<uint8_t> &pixels) {
+    if (!m_captured || !m_readback) {
+      return false;
+    }
+    m_captured = false;
+    SDL_WaitForGPUIdle(m_device.get());
+    auto *data = static_cast<const uint8_t *>(
+        SDL_MapGPUTransferBuffer(m_device.get(), m_readback, false));
+    if (!data) {
+      spdlog::error("映射回读buffer失败{}", SDL_GetError());
+      return false;
+    }
+    size_t size = static_cast<size_t>(m_window_size.x) *
+                  static_cast<size_t>(m_window_size.y) * 4;
+    pixels.assign(data, data + size);
+    SDL_UnmapGPUTransferBuffer(m_device.get(), m_readback);
+    return true;
+  }
+
+  bool bindPipeline(const PipelineDesc &desc) {
+    auto id = m_pipeline_cache->get(desc);
+    return id && bindPipeline(*id);
+  }
+
+  bool bindPipeline(uint8_t id) {
+    SDL_GPUGraphicsPipeline *pipeline = m_pipeline_cache->at(id);
+    if (!pipeline || !beginRenderPass()) {
+      return false;
+    }
+    if (pipeline == m_bound.pipeline) {
+      m_stats.skipped_calls++;
+    } else {
+      SDL_BindGPUGraphicsPipeline(m_context.render_pass, pipeline);
+      m_bound.pipeline = pipeline;
+      m_stats.pipeline_binds++;
+    }
+    // bind vertex input
+    if (m_vertex_buffer && m_bound.vertex_buffer != m_vertex_buffer) {
+      SDL_GPUBufferBinding vbind{
+          .buffer = m_vertex_buffer,
+          .offset = 0,
+      };
+      SDL_BindGPUVertexBuffers(m_context.render_pass, 0, &vbind, 1);
+      m_bound.vertex_buffer = m_vertex_buffer;
+      m_stats.buffer_binds++;
+    }
+    if (m_index_buffer && m_bound.index_buffer != m_index_buffer) {
+      SDL_GPUBufferBinding ibind{
+          .buffer = m_index_buffer,
+          .offset = 0,
+      };
+      SDL_BindGPUIndexBuffer(m_context.render_pass, &ibind,
+                             SDL_GPU_INDEXELEMENTSIZE_32BIT);
+      m_bound.index_buffer = m_index_buffer;
+      m_stats.buffer_binds++;
     }
+    return true;
   }
 
-  void bindTexture(SDL_GPUTexture *texture) {
-    if (texture && m_sampler && m_context.render_pass) {
-      SDL_GPUTextureSamplerBinding texture_binding{.texture = texture,
-                                                   .sampler = m_sampler};
-      SDL_BindGPUFragmentSamplers(m_context.render_pass, 0, &texture_binding,
-                                  1);
+  // 绑定到顶点阶段storage buffer的0号槽位
+  void bindStorageBuffer(SDL_GPUBuffer *buffer) {
+    if (!buffer || !m_context.render_pass) {
+      return;
+    }
+    if (buffer == m_bound.storage_buffer) {
+      m_stats.skipped_calls++;
+      return;
     }
+    SDL_BindGPUVertexStorageBuffers(m_context.render_pass, 0, &buffer, 1);
+    m_bound.storage_buffer = buffer;
+    m_stats.buffer_binds++;
   }
 
-  void draw() {
-    if (m_context.render_pass) {
-      SDL_DrawGPUIndexedPrimitives(m_context.render_pass, 6, 1, 0, 0, 0);
+  // 和该槽位上次推送的内容相同时跳过
+  template <typename T>
+  void pushVertexUniform(const T &val, uint32_t slot = 0) {
+    if (!m_context.cmd || slot >= kUniformSlots) {
+      return;
+    }
+    auto &last = m_vertex_uniforms[slot];
+    const auto *bytes = reinterpret_cast<const uint8_t *>(&val);
+    if (last.size() == sizeof(T) &&
+        std::memcmp(last.data(), bytes, sizeof(T)) == 0) {
+      m_stats.skipped_calls++;
+      return;
+    }
+    last.assign(bytes, bytes + sizeof(T));
+    SDL_PushGPUVertexUniformData(m_context.cmd, slot, &val, sizeof(T));
+    m_stats.uniform_bytes += sizeof(T);
+  }
+
+  // sampler为空时使用默认的nearest/clamp采样器
+  void bindTexture(SDL_GPUTexture *texture, SDL_GPUSampler *sampler = nullptr) {
+    if (!sampler) {
+      sampler = m_sampler;
+    }
+    if (!texture || !sampler || !m_context.render_pass) {
+      return;
+    }
+    if (texture == m_bound.texture && sampler == m_bound.sampler) {
+      m_stats.skipped_calls++;
+      return;
+    }
+    SDL_GPUTextureSamplerBinding texture_binding{.texture = texture,
+                                                 .sampler = sampler};
+    SDL_BindGPUFragmentSamplers(m_context.render_pass, 0, &texture_binding, 1);
+    m_bound.texture = texture;
+    m_bound.sampler = sampler;
+    m_stats.texture_binds++;
+    // 被跳过的重复绑定已经在本帧记录过
+    if (auto it = m_texture_ids.find(texture); it != m_texture_ids.end()) {
+      it->second.last_bound = m_frame_index;
     }
   }
 
+  void draw() { drawInstanced(1, 0); }
+
+  void drawInstanced(uint32_t count, uint32_t first) {
+    if (m_context.render_pass && count > 0) {
+      SDL_DrawGPUIndexedPrimitives(m_context.render_pass, 6, count, 0, 0,
+                                   first);
+      m_stats.draw_calls++;
+    }
+  }
+
+  // 精灵管线的排序键，自定义渲染也可以用它来提交
+  // 只读，可以在工作线程调用
+  uint64_t makeSpriteKey(uint8_t layer, const TextureRegion &region,
+                         float depth,
+                         BlendMode blend = BlendMode::Opaque) const {
+    return DrawKey::make(layer, m_sprite_pipelines[static_cast<size_t>(blend)],
+                         region.id, depth);
+  }
+
+  // 延迟到end()排序后统一绘制
+  void submit(uint64_t key, SDL_GPUTexture *texture, const TileInfo &info) {
+    if (texture && m_sprite_batch && m_context.cmd) {
+      m_sprite_batch->submit(key, texture, info);
+    }
+  }
+
+  void submitTile(uint8_t layer, float depth, const TextureRegion &region,
+                  const TileInfo &info, BlendMode blend = BlendMode::Opaque) {
+    submit(makeSpriteKey(layer, region, depth, blend), region.texture, info);
+  }
+
+  // 合并工作线程收集的精灵，按段号顺序调用
+  void submitSegment(const SpriteSegment &segment) {
+    if (m_sprite_batch && m_context.cmd) {
+      m_sprite_batch->merge(segment);
+    }
+  }
+
+  // 提交已经上传到storage buffer的TileInfo实例，和精灵一起按键排序
+  void submitInstances(uint8_t layer, float depth, const TextureRegion &region,
+                       SDL_GPUBuffer *buffer, uint32_t first, uint32_t count,
+                       BlendMode blend = BlendMode::Opaque) {
+    if (buffer && region.texture && count > 0 && m_sprite_batch &&
+        m_context.cmd) {
+      m_sprite_batch->submitStatic(makeSpriteKey(layer, region, depth, blend),
+                                   buffer, region.texture, first, count);
+    }
+  }
+
+  // 场景剔除后上报本帧的可见和剔除数量
+  void addCullStats(uint32_t visible, uint32_t culled) {
+    m_stats.visible += visible;
+    m_stats.culled += culled;
+  }
+
+  void setInterpolation(float alpha) { m_interpolation = alpha; }
+  // 渲染期间只读，可以在工作线程调用
+  float getInterpolation() const { return m_interpolation; }
+
+  Camera &getCamera() { return m_camera; }
+  const Camera &getCamera() const { return m_camera; }
+
+  // 上一帧的统计
+  const RenderStats &getStats() const { return m_last_stats; }
+  // 启动以来的累计上传统计
+  const UploadStats &getUploadStats() const {
+    return m_upload_ring->getStats();
+  }
+
   template <typename... Args>
-  std::unique_ptr<Tile> createTile(engine::core::Context &context,
-                                   std::string_view path, Args &&...args) {
-    auto ret = std::make_unique<Tile>(this, std::forward<Args>(args)...);
+  engine::core::PoolPtr<Tile> createTile(engine::core::Context &context,
+                                         std::string_view path,
+                                         Args &&...args) {
+    auto ret = m_tile_pool.make(this, std::forward<Args>(args)...);
     ret->init(context, path);
     return ret;
   }
+  const engine::core::PoolStats &getTilePoolStats() const {
+    return m_tile_pool.getStats();
+  }
 
-  glm::vec2 getWindowSize() const {
-    int w, h;
-    SDL_GetWindowSize(m_window.get(), &w, &h);
-    return {static_cast<float>(w), static_cast<float>(h)};
+  // 窗口所在显示器的刷新率，无窗口或未知时返回0
+  double getRefreshRate() const {
+    if (!m_window) {
+      return 0.0;
+    }
+    const SDL_DisplayMode *mode =
+        SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(m_window.get()));
+    if (!mode) {
+      return 0.0;
+    }
+    if (mode->refresh_rate_denominator > 0) {
+      return static_cast<double>(mode->refresh_rate_numerator) /
+             mode->refresh_rate_denominator;
+    }
+    return mode->refresh_rate;
   }
 
+  // 本帧begin()时的窗口大小，无窗口模式下是离屏贴图大小
+  glm::vec2 getWindowSize() const { return m_window_size; }
+
   Renderer(Renderer &) = delete;
   Renderer(Renderer &&) = delete;
   Renderer &operator=(Renderer &) = delete;
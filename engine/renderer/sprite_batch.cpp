@@ -0,0 +1,120 @@
+#include "sprite_batch.hpp"
+#include "SDL3/SDL_error.h"
+#include "SDL3/SDL_timer.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <bit>
+
+namespace engine::render {
+
+SpriteBatch::~SpriteBatch() {
+  if (m_device) {
+    if (m_instance_buffer) {
+      SDL_ReleaseGPUBuffer(m_device, m_instance_buffer);
+      m_instance_buffer = nullptr;
+    }
+  }
+}
+
+bool SpriteBatch::reserve(uint32_t count) {
+  if (count <= m_capacity && m_instance_buffer) {
+    return true;
+  }
+  // 按2的幂增长，避免频繁重建
+  uint32_t capacity = std::bit_ceil(std::max(count, 1024u));
+  uint32_t size = capacity * static_cast<uint32_t>(sizeof(TileInfo));
+
+  // 旧的buffer由SDL在gpu用完后释放
+  if (m_instance_buffer) {
+    SDL_ReleaseGPUBuffer(m_device, m_instance_buffer);
+    m_instance_buffer = nullptr;
+  }
+  m_capacity = 0;
+
+  SDL_GPUBufferCreateInfo buff_info{
+      .usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ,
+      .size = size,
+      .props = 0,
+  };
+  m_instance_buffer = SDL_CreateGPUBuffer(m_device, &buff_info);
+  if (!m_instance_buffer) {
+    spdlog::error("创建实例buffer失败{}", SDL_GetError());
+    return false;
+  }
+  m_capacity = capacity;
+  spdlog::trace("精灵批次容量扩展到{}", capacity);
+  return true;
+}
+
+void SpriteBatch::merge(const SpriteSegment &segment) {
+  auto offset = static_cast<uint32_t>(m_instances.size());
+  m_draw_list.reserve(m_draw_list.size() +
+                      static_cast<uint32_t>(segment.items.size()));
+  for (const auto &item : segment.items) {
+    m_draw_list.submit(item.key, offset + item.payload);
+  }
+  m_instances.insert(m_instances.end(), segment.instances.begin(),
+                     segment.instances.end());
+  m_textures.insert(m_textures.end(), segment.textures.begin(),
+                    segment.textures.end());
+}
+
+void SpriteBatch::build() {
+  uint64_t start = SDL_GetTicksNS();
+  m_draw_list.sort();
+  m_sort_time_ns = SDL_GetTicksNS() - start;
+
+  // 按排序后的顺序重排实例，只在管线或贴图变化处断开
+  m_runs.clear();
+  m_sorted.clear();
+  m_sorted.reserve(m_instances.size());
+  for (const auto &item : m_draw_list.getItems()) {
+    uint8_t pipeline = DrawKey::pipeline(item.key);
+    if (item.payload & kStaticFlag) {
+      const Static &draw = m_statics[item.payload & ~kStaticFlag];
+      m_runs.push_back(Run{.pipeline = pipeline,
+                           .texture = draw.texture,
+                           .buffer = draw.buffer,
+                           .first = draw.first,
+                           .count = draw.count});
+      continue;
+    }
+    SDL_GPUTexture *texture = m_textures[item.payload];
+    if (m_runs.empty() || m_runs.back().buffer ||
+        m_runs.back().pipeline != pipeline ||
+        m_runs.back().texture != texture) {
+      m_runs.push_back(Run{.pipeline = pipeline,
+                           .texture = texture,
+                           .first = static_cast<uint32_t>(m_sorted.size()),
+                           .count = 0});
+    }
+    m_runs.back().count++;
+    m_sorted.push_back(m_instances[item.payload]);
+  }
+}
+
+bool SpriteBatch::upload(UploadRing &ring) {
+  if (empty()) {
+    return false;
+  }
+  build();
+  if (m_instances.empty()) {
+    return true;
+  }
+  if (!reserve(size())) {
+    return false;
+  }
+  uint32_t bytes = size() * static_cast<uint32_t>(sizeof(TileInfo));
+  // cycle避免覆盖上一帧gpu还在读的数据
+  return ring.uploadBuffer(m_instance_buffer, 0, m_sorted.data(), bytes, true);
+}
+
+void SpriteBatch::clear() {
+  m_instances.clear();
+  m_textures.clear();
+  m_statics.clear();
+  m_draw_list.clear();
+  m_runs.clear();
+}
+
+} // namespace engine::render
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include "draw_list.hpp"
+#include "tile.hpp"
+#include "upload_ring.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace engine::render {
+
+/*
+ * 一个线程收集的精灵，payload是段内下标
+ * 按段号顺序合并进批次，结果和串行提交完全一致
+ */
+struct SpriteSegment {
+  std::vector<DrawItem> items;
+  std::vector<TileInfo> instances;
+  std::vector<SDL_GPUTexture *> textures;
+  // 该段的剔除结果
+  uint32_t visible{0};
+  uint32_t culled{0};
+
+  void submit(uint64_t key, SDL_GPUTexture *texture, const TileInfo &info) {
+    auto payload = static_cast<uint32_t>(instances.size());
+    items.push_back(DrawItem{.key = key, .payload = payload});
+    instances.push_back(info);
+    textures.push_back(texture);
+  }
+
+  void clear() {
+    items.clear();
+    instances.clear();
+    textures.clear();
+    visible = 0;
+    culled = 0;
+  }
+};
+
+/*
+ * 收集一帧内所有tile，按排序键排序后一次性上传到storage buffer
+ * 管线或贴图相同的连续实例合并成一次实例化绘制
+ * 已经在gpu上的实例(如瓦片地图的区块)作为静态项一起参与排序
+ */
+class SpriteBatch final {
+public:
+  struct Run {
+    uint8_t pipeline{0};
+    SDL_GPUTexture *texture{nullptr};
+    // 为空时从批次的实例buffer读取
+    SDL_GPUBuffer *buffer{nullptr};
+    uint32_t first{0};
+    uint32_t count{0};
+  };
+
+private:
+  struct Static {
+    SDL_GPUBuffer *buffer;
+    SDL_GPUTexture *texture;
+    uint32_t first;
+    uint32_t count;
+  };
+  // payload最高位表示静态项
+  static constexpr uint32_t kStaticFlag = 0x80000000u;
+
+  SDL_GPUDevice *m_device{nullptr};
+  SDL_GPUBuffer *m_instance_buffer{nullptr};
+  uint32_t m_capacity{0};
+
+  // 提交顺序，下标即排序项的payload
+  std::vector<TileInfo> m_instances;
+  std::vector<SDL_GPUTexture *> m_textures;
+  std::vector<Static> m_statics;
+  DrawList m_draw_list;
+  // 排序后的顺序
+  std::vector<TileInfo> m_sorted;
+  std::vector<Run> m_runs;
+  uint64_t m_sort_time_ns{0};
+
+private:
+  bool reserve(uint32_t count);
+
+public:
+  SpriteBatch(SDL_GPUDevice *device) : m_device{device} {}
+  ~SpriteBatch();
+
+  void submit(uint64_t key, SDL_GPUTexture *texture, const TileInfo &info) {
+    m_draw_list.submit(key, static_cast<uint32_t>(m_instances.size()));
+    m_instances.push_back(info);
+    m_textures.push_back(texture);
+  }
+
+  // 追加一个线程收集的精灵
+  void merge(const SpriteSegment &segment);
+
+  // buffer中[first, first + count)的实例已经在gpu上，不需要上传
+  void submitStatic(uint64_t key, SDL_GPUBuffer *buffer,
+                    SDL_GPUTexture *texture, uint32_t first, uint32_t count) {
+    m_draw_list.submit(key,
+                       kStaticFlag | static_cast<uint32_t>(m_statics.size()));
+    m_statics.push_back(Static{
+        .buffer = buffer, .texture = texture, .first = first, .count = count});
+  }
+
+  // 排序并按管线/贴图边界生成绘制段，upload会调用
+  void build();
+  // 实例数据写入上传环，随本帧的copy pass一起上传
+  bool upload(UploadRing &ring);
+  void clear();
+
+  bool empty() const { return m_instances.empty() && m_statics.empty(); }
+  uint32_t size() const { return static_cast<uint32_t>(m_instances.size()); }
+  SDL_GPUBuffer *getInstanceBuffer() const { return m_instance_buffer; }
+  const std::vector<Run> &getRuns() const { return m_runs; }
+  uint64_t getSortTime() const { return m_sort_time_ns; }
+
+  SpriteBatch(SpriteBatch &) = delete;
+  SpriteBatch(SpriteBatch &&) = delete;
+  SpriteBatch &operator=(SpriteBatch &) = delete;
+  SpriteBatch &operator=(SpriteBatch &&) = delete;
+};
+
+} // namespace engine::render
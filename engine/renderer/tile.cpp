@@ -1,6 +1,7 @@
 #include "tile.hpp"
 #include "../resource_manager/resource_manager.hpp"
 #include "renderer.hpp"
+#include "sprite_batch.hpp"
 #include "spdlog/spdlog.h"
 #include <string>
 
@@ -13,36 +14,67 @@ Tile::~Tile() = default;
 //   }
 // }
 
-void Tile::init(std::string_view texture_path) {
-  if (m_owner) {
-    m_texture = m_owner->createTexture(texture_path);
-    if (!m_texture) {
-      spdlog::error("创建gpu texture失败");
-      return;
-    }
-    m_init = true;
-  }
-}
-
 void Tile::init(engine::core::Context &context, std::string_view texture_path) {
   std::string tp{texture_path};
-  m_texture = context.getResource().textureGetOrLoad(tp);
-  if (!m_texture) {
+  m_resources = &context.getResource();
+  // 不阻塞场景初始化，贴图就绪后才开始绘制
+  m_texture = m_resources->textureLoadAsync(tp);
+  m_init = m_texture.valid();
+}
+
+const TextureRegion *Tile::resolve() {
+  if (!m_resources) {
+    return nullptr;
+  }
+  // 被驱逐时textureGet会请求重新加载
+  if (const TextureRegion *region = m_resources->textureGet(m_texture)) {
+    return region;
+  }
+  if (m_resources->textureState(m_texture) ==
+      engine::resource::LoadState::Failed) {
     spdlog::error("创建gpu texture失败");
-    return;
+    m_init = false;
+  }
+  return nullptr;
+}
+
+bool Tile::isPending() const {
+  if (!m_resources) {
+    return false;
   }
-  m_init = true;
+  auto state = m_resources->textureState(m_texture);
+  return state == engine::resource::LoadState::Pending ||
+         state == engine::resource::LoadState::Evicted;
+}
+
+glm::vec2 Tile::getRenderPos() const {
+  return glm::mix(m_prev_pos, m_tile_info.pos, m_owner->getInterpolation());
 }
 
 void Tile::render() {
-  if (m_init) {
-    m_owner->bindPipeline<TilePipeline>();
-    // TODO 每次都要获取？
-    RenderInfo rinfo{m_owner->getWindowSize()};
-    m_owner->pushVertexUniform<RenderInfo>(rinfo);
-    m_owner->pushVertexUniform<TileInfo>(m_tile_info);
-    m_owner->bindTexture(m_texture);
-    m_owner->draw();
+  if (!m_init) {
+    return;
+  }
+  if (const TextureRegion *region = resolve()) {
+    TileInfo info = m_tile_info;
+    info.pos = getRenderPos();
+    info.uv = region->uv;
+    // 交给精灵批次，end()时排序后合并成实例化绘制
+    m_owner->submitTile(m_layer, m_depth, *region, info, m_blend);
+  }
+}
+
+void Tile::render(SpriteSegment &segment) {
+  if (!m_init) {
+    return;
+  }
+  if (const TextureRegion *region = resolve()) {
+    TileInfo info = m_tile_info;
+    info.pos = getRenderPos();
+    info.uv = region->uv;
+    segment.submit(
+        m_owner->makeSpriteKey(m_layer, *region, m_depth, m_blend),
+        region->texture, info);
   }
 }
 } // namespace engine::render
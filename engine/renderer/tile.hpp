@@ -1,23 +1,35 @@
 #pragma once
 
 #include "../core/context.hpp"
+#include "../resource_manager/handle.hpp"
+#include "camera.hpp"
+#include "pipelines/base.hpp"
 #include "SDL3/SDL_gpu.h"
 #include "glm/glm.hpp"
 #include <glm/ext/vector_int2.hpp>
 #include <locale>
+#include <memory>
 #include <string_view>
 
+namespace engine::resource {
+class Manager;
+}
+
 namespace engine::render {
 
 class Renderer;
+struct SpriteSegment;
 
+// 每帧的uniform，相机的view-projection矩阵
 struct RenderInfo {
-  glm::vec2 window_size;
+  glm::mat4 view_proj;
 };
 
 struct TileInfo {
   glm::vec2 pos;
   glm::vec2 size{200.0f, 200.0f};
+  // 贴图中的uv子区域(x, y, w, h)，图集中的贴图只占一部分
+  glm::vec4 uv{0.0f, 0.0f, 1.0f, 1.0f};
   // TODO
   // glm::vec2 scale{1.0f, 1.0f};
   // float rotation{0.0f};
@@ -26,30 +38,73 @@ struct TileInfo {
   // bool fliph{false};
 };
 
+// 贴图或者图集页中的一块区域
+struct TextureRegion {
+  SDL_GPUTexture *texture{nullptr};
+  glm::vec4 uv{0.0f, 0.0f, 1.0f, 1.0f};
+  glm::vec2 size{0.0f, 0.0f};
+  // Renderer分配的贴图id，用于排序键
+  uint16_t id{0};
+
+  bool valid() const { return texture != nullptr; }
+};
+
 class Tile final {
   friend class Renderer;
 
 private:
   Renderer *m_owner{nullptr};
   TileInfo m_tile_info;
-  SDL_GPUTexture *m_texture;
+  // 上一个tick的位置，绘制时和当前位置插值
+  glm::vec2 m_prev_pos{0.0f, 0.0f};
+  // 贴图由资源管理器持有，加载完成前和被驱逐后不绘制
+  engine::resource::Manager *m_resources{nullptr};
+  engine::resource::TextureHandle m_texture;
+  // 绘制层，越大越靠上
+  uint8_t m_layer{0};
+  // 同一层同一贴图内的绘制顺序
+  float m_depth{0.0f};
+  BlendMode m_blend{BlendMode::Opaque};
   bool m_init{false};
 
+private:
+  // 从句柄取出本帧的区域，不能绘制时返回空
+  const TextureRegion *resolve();
+
 public:
   Tile(Renderer *renderer, const glm::vec2 &pos = {0.0f, 0.0f})
-      : m_owner(renderer), m_tile_info{.pos = pos} {}
+      : m_owner(renderer), m_tile_info{.pos = pos}, m_prev_pos{pos} {}
   ~Tile();
 
-  void init(std::string_view texture_path);
   void render();
+  // 提交到工作线程自己的段，不访问渲染器的可变状态
+  void render(SpriteSegment &segment);
 
   void init(engine::core::Context &context, std::string_view texture_path);
 
   void move(const glm::vec2 &val) { m_tile_info.pos += val; }
   void setPos(const glm::vec2 &val) { m_tile_info.pos = val; }
   const glm::vec2 &getPos() const { return m_tile_info.pos; }
+  // 每个tick开始前调用，记录插值起点
+  void savePrevious() { m_prev_pos = m_tile_info.pos; }
+  // 按渲染器的插值系数在上一个tick和当前tick之间插值
+  glm::vec2 getRenderPos() const;
   void setSize(const glm::vec2 &val) { m_tile_info.size = val; }
   const glm::vec2 &getSize() const { return m_tile_info.size; }
+  // pos是中心点，包含上一个tick的位置，插值后仍在包围盒内
+  AABB getBounds() const {
+    glm::vec2 half = m_tile_info.size * 0.5f;
+    return AABB{.min = glm::min(m_prev_pos, m_tile_info.pos) - half,
+                .max = glm::max(m_prev_pos, m_tile_info.pos) + half};
+  }
+  engine::resource::TextureHandle getTexture() const { return m_texture; }
+  bool isPending() const;
+  void setLayer(uint8_t layer) { m_layer = layer; }
+  uint8_t getLayer() const { return m_layer; }
+  void setDepth(float depth) { m_depth = depth; }
+  float getDepth() const { return m_depth; }
+  void setBlend(BlendMode blend) { m_blend = blend; }
+  BlendMode getBlend() const { return m_blend; }
 
   Tile(Tile &) = delete;
   Tile(Tile &&) = delete;
@@ -0,0 +1,369 @@
+#include "tilemap.hpp"
+#include "../resource_manager/resource_manager.hpp"
+#include "nlohmann/json.hpp"
+#include "renderer.hpp"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <string>
+
+namespace engine::render {
+
+namespace {
+// Tiled在gid高位存翻转标记，目前不支持翻转
+constexpr uint32_t kGidMask = 0x1fffffffu;
+} // namespace
+
+glm::vec4 Tileset::uv(uint32_t gid) const {
+  uint32_t index = gid - first_gid;
+  uint32_t col = index % columns;
+  uint32_t row = index / columns;
+  auto tw = static_cast<uint32_t>(tile_size.x);
+  auto th = static_cast<uint32_t>(tile_size.y);
+  auto px = static_cast<float>(margin + col * (tw + spacing));
+  auto py = static_cast<float>(margin + row * (th + spacing));
+  // 先算图块在整张贴图中的归一化位置，再映射到图集中的子区域
+  return glm::vec4{
+      region_uv.x + px / image_size.x * region_uv.z,
+      region_uv.y + py / image_size.y * region_uv.w,
+      tile_size.x / image_size.x * region_uv.z,
+      tile_size.y / image_size.y * region_uv.w,
+  };
+}
+
+Tilemap::Tilemap(engine::core::Context &context, uint32_t width,
+                 uint32_t height, const glm::vec2 &tile_size)
+    : m_owner{&context.getRenderer()}, m_resources{&context.getResource()},
+      m_width{width}, m_height{height},
+      m_tile_size{tile_size}, m_tiles(size_t{width} * height, 0),
+      m_chunks_x{(width + kChunkSize - 1) / kChunkSize},
+      m_chunks_y{(height + kChunkSize - 1) / kChunkSize},
+      m_chunks(size_t{m_chunks_x} * m_chunks_y) {
+  updateBounds();
+  m_stats.chunks = static_cast<uint32_t>(m_chunks.size());
+}
+
+Tilemap::~Tilemap() {
+  if (m_owner) {
+    for (auto &chunk : m_chunks) {
+      m_owner->destroyBuffer(chunk.buffer);
+      chunk.buffer = nullptr;
+    }
+  }
+}
+
+void Tilemap::updateBounds() {
+  for (uint32_t cy = 0; cy < m_chunks_y; cy++) {
+    for (uint32_t cx = 0; cx < m_chunks_x; cx++) {
+      // 行从上往下，y轴向上
+      uint32_t x0 = cx * kChunkSize;
+      uint32_t y0 = cy * kChunkSize;
+      uint32_t x1 = std::min(x0 + kChunkSize, m_width);
+      uint32_t y1 = std::min(y0 + kChunkSize, m_height);
+      auto &chunk = m_chunks[cy * m_chunks_x + cx];
+      chunk.bounds.min = m_origin + glm::vec2{x0 * m_tile_size.x,
+                                              (m_height - y1) * m_tile_size.y};
+      chunk.bounds.max = m_origin + glm::vec2{x1 * m_tile_size.x,
+                                              (m_height - y0) * m_tile_size.y};
+    }
+  }
+}
+
+void Tilemap::setOrigin(const glm::vec2 &val) {
+  m_origin = val;
+  updateBounds();
+  for (auto &chunk : m_chunks) {
+    chunk.dirty = true;
+  }
+}
+
+AABB Tilemap::getBounds() const {
+  return AABB{.min = m_origin,
+              .max = m_origin + glm::vec2{m_width * m_tile_size.x,
+                                          m_height * m_tile_size.y}};
+}
+
+void Tilemap::addTileset(const Tileset &tileset) {
+  m_tilesets.push_back(tileset);
+  for (auto &chunk : m_chunks) {
+    chunk.dirty = true;
+  }
+}
+
+void Tilemap::markDirty(uint32_t x, uint32_t y) {
+  m_chunks[(y / kChunkSize) * m_chunks_x + x / kChunkSize].dirty = true;
+}
+
+void Tilemap::setTile(uint32_t x, uint32_t y, uint32_t gid) {
+  if (x >= m_width || y >= m_height) {
+    return;
+  }
+  gid &= kGidMask;
+  uint32_t &tile = m_tiles[size_t{y} * m_width + x];
+  if (tile != gid) {
+    tile = gid;
+    markDirty(x, y);
+  }
+}
+
+uint32_t Tilemap::getTile(uint32_t x, uint32_t y) const {
+  if (x >= m_width || y >= m_height) {
+    return 0;
+  }
+  return m_tiles[size_t{y} * m_width + x];
+}
+
+void Tilemap::fill(const std::vector<uint32_t> &gids) {
+  size_t count = std::min(gids.size(), m_tiles.size());
+  for (size_t i = 0; i < count; i++) {
+    m_tiles[i] = gids[i] & kGidMask;
+  }
+  for (auto &chunk : m_chunks) {
+    chunk.dirty = true;
+  }
+}
+
+bool Tilemap::bake(uint32_t cx, uint32_t cy, Chunk &chunk) {
+  chunk.ranges.clear();
+  m_scratch.clear();
+  uint32_t x0 = cx * kChunkSize;
+  uint32_t y0 = cy * kChunkSize;
+  uint32_t x1 = std::min(x0 + kChunkSize, m_width);
+  uint32_t y1 = std::min(y0 + kChunkSize, m_height);
+  // 按图块集分组，每组一次绘制
+  for (uint32_t ts = 0; ts < m_tilesets.size(); ts++) {
+    const Tileset &tileset = m_tilesets[ts];
+    if (!tileset.texture.valid()) {
+      continue;
+    }
+    auto first = static_cast<uint32_t>(m_scratch.size());
+    for (uint32_t y = y0; y < y1; y++) {
+      for (uint32_t x = x0; x < x1; x++) {
+        uint32_t gid = m_tiles[size_t{y} * m_width + x];
+        if (!tileset.contains(gid)) {
+          continue;
+        }
+        glm::vec2 pos{(x + 0.5f) * m_tile_size.x,
+                      (m_height - y - 0.5f) * m_tile_size.y};
+        m_scratch.push_back(TileInfo{
+            .pos = m_origin + pos,
+            .size = m_tile_size,
+            .uv = tileset.uv(gid),
+        });
+      }
+    }
+    auto count = static_cast<uint32_t>(m_scratch.size()) - first;
+    if (count > 0) {
+      chunk.ranges.push_back(
+          Range{.tileset = ts, .first = first, .count = count});
+    }
+  }
+  if (m_scratch.empty()) {
+    chunk.dirty = false;
+    return true;
+  }
+
+  auto count = static_cast<uint32_t>(m_scratch.size());
+  if (count > chunk.capacity) {
+    m_owner->destroyBuffer(chunk.buffer);
+    chunk.capacity = std::bit_ceil(count);
+    chunk.buffer = m_owner->createStorageBuffer(
+        chunk.capacity * static_cast<uint32_t>(sizeof(TileInfo)));
+    if (!chunk.buffer) {
+      chunk.capacity = 0;
+      chunk.ranges.clear();
+      return false;
+    }
+  }
+  // 上传失败时保留dirty，下一帧重新烘焙
+  if (!m_owner->uploadBuffer(chunk.buffer, m_scratch.data(),
+                             count * static_cast<uint32_t>(sizeof(TileInfo)))) {
+    chunk.ranges.clear();
+    return false;
+  }
+  chunk.dirty = false;
+  m_stats.baked_chunks++;
+  return true;
+}
+
+void Tilemap::render(const AABB &view) {
+  m_stats.visible_chunks = 0;
+  m_stats.baked_chunks = 0;
+  m_stats.instances = 0;
+  if (!m_owner || !getBounds().intersects(view)) {
+    return;
+  }
+  // 被驱逐的图块集贴图在这里请求重新加载，就绪前跳过
+  m_regions.clear();
+  for (const auto &tileset : m_tilesets) {
+    m_regions.push_back(m_resources->textureGet(tileset.texture));
+  }
+  for (uint32_t cy = 0; cy < m_chunks_y; cy++) {
+    for (uint32_t cx = 0; cx < m_chunks_x; cx++) {
+      auto &chunk = m_chunks[cy * m_chunks_x + cx];
+      if (!chunk.bounds.intersects(view)) {
+        continue;
+      }
+      // 只在区块进入视野时才烘焙
+      if (chunk.dirty && !bake(cx, cy, chunk)) {
+        continue;
+      }
+      m_stats.visible_chunks++;
+      for (const auto &range : chunk.ranges) {
+        const TextureRegion *region = m_regions[range.tileset];
+        if (!region) {
+          continue;
+        }
+        m_owner->submitInstances(m_layer, m_depth, *region, chunk.buffer,
+                                 range.first, range.count, m_blend);
+        m_stats.instances += range.count;
+      }
+    }
+  }
+}
+
+namespace {
+// 字段类型不对时value()会抛出json::exception，由loadTiledMap统一处理
+std::vector<std::unique_ptr<Tilemap>>
+parseTiledMap(engine::core::Context &context, const nlohmann::json &json,
+              const std::filesystem::path &file) {
+  std::vector<std::unique_ptr<Tilemap>> ret;
+  if (json.value("infinite", false)) {
+    spdlog::error("不支持无限地图{}", file.string());
+    return ret;
+  }
+
+  auto dir = file.parent_path();
+  glm::vec2 tile_size{json.value("tilewidth", 0.0f),
+                      json.value("tileheight", 0.0f)};
+  std::vector<Tileset> tilesets;
+  for (auto tileset_json : json.value("tilesets", nlohmann::json::array())) {
+    if (!tileset_json.is_object()) {
+      spdlog::error("图块集不是对象");
+      continue;
+    }
+    uint32_t first_gid = tileset_json.value("firstgid", 1u);
+    auto base = dir;
+    // 外部图块集
+    if (tileset_json.contains("source")) {
+      if (!tileset_json["source"].is_string()) {
+        spdlog::error("图块集的source不是字符串");
+        continue;
+      }
+      auto source = dir / tileset_json["source"].get<std::string>();
+      std::ifstream tin{source};
+      tileset_json = nlohmann::json::parse(tin, nullptr, false);
+      if (tileset_json.is_discarded() || !tileset_json.is_object()) {
+        spdlog::error("解析图块集{}失败", source.string());
+        continue;
+      }
+      base = source.parent_path();
+    }
+    if (!tileset_json.contains("image")) {
+      spdlog::error("不支持由单独图片组成的图块集");
+      continue;
+    }
+    if (!tileset_json["image"].is_string()) {
+      spdlog::error("图块集的image不是字符串");
+      continue;
+    }
+    Tileset tileset{
+        .texture = {},
+        .region_uv = {0.0f, 0.0f, 1.0f, 1.0f},
+        .image_size = {tileset_json.value("imagewidth", 0.0f),
+                       tileset_json.value("imageheight", 0.0f)},
+        .tile_size = {tileset_json.value("tilewidth", 0.0f),
+                      tileset_json.value("tileheight", 0.0f)},
+        .columns = std::max(tileset_json.value("columns", 1u), 1u),
+        .count = tileset_json.value("tilecount", 0u),
+        .margin = tileset_json.value("margin", 0u),
+        .spacing = tileset_json.value("spacing", 0u),
+        .first_gid = first_gid,
+    };
+    auto image = (base / tileset_json["image"].get<std::string>()).string();
+    auto &resources = context.getResource();
+    tileset.texture = resources.textureLoad(image);
+    const TextureRegion *region = resources.textureGet(tileset.texture);
+    if (region) {
+      tileset.region_uv = region->uv;
+    }
+    if (!region || tileset.image_size.x <= 0.0f ||
+        tileset.image_size.y <= 0.0f) {
+      spdlog::error("加载图块集贴图{}失败", image);
+      continue;
+    }
+    tilesets.push_back(tileset);
+  }
+
+  uint8_t layer = 0;
+  for (const auto &layer_json : json.value("layers", nlohmann::json::array())) {
+    if (!layer_json.is_object()) {
+      spdlog::error("地图层不是对象");
+      continue;
+    }
+    if (layer_json.value("type", "") != "tilelayer") {
+      continue;
+    }
+    if (!layer_json.contains("data") || !layer_json["data"].is_array()) {
+      // base64/压缩格式需要在Tiled中导出为CSV
+      spdlog::error("地图层{}不是CSV格式", layer_json.value("name", ""));
+      continue;
+    }
+    // 手动编辑的地图可能有负数或小数，逐个检查避免抛出异常
+    std::vector<uint32_t> gids;
+    gids.reserve(layer_json["data"].size());
+    for (const auto &gid : layer_json["data"]) {
+      if (!gid.is_number_unsigned() ||
+          gid.get<uint64_t>() > std::numeric_limits<uint32_t>::max()) {
+        break;
+      }
+      gids.push_back(static_cast<uint32_t>(gid.get<uint64_t>()));
+    }
+    if (gids.size() != layer_json["data"].size()) {
+      spdlog::error("地图层{}包含无效的图块编号", layer_json.value("name", ""));
+      continue;
+    }
+    uint32_t width = layer_json.value("width", 0u);
+    uint32_t height = layer_json.value("height", 0u);
+    auto tilemap =
+        std::make_unique<Tilemap>(context, width, height, tile_size);
+    for (const auto &tileset : tilesets) {
+      tilemap->addTileset(tileset);
+    }
+    tilemap->fill(gids);
+    tilemap->setOrigin({layer_json.value("offsetx", 0.0f),
+                        -layer_json.value("offsety", 0.0f)});
+    tilemap->setLayer(layer++);
+    tilemap->setBlend(BlendMode::Alpha);
+    ret.push_back(std::move(tilemap));
+  }
+  spdlog::trace("加载地图{}，{}层", file.string(), ret.size());
+  return ret;
+}
+} // namespace
+
+std::vector<std::unique_ptr<Tilemap>>
+loadTiledMap(engine::core::Context &context, std::string_view path) {
+  std::filesystem::path file{path};
+  std::ifstream in{file};
+  if (!in) {
+    spdlog::error("打开地图{}失败", file.string());
+    return {};
+  }
+  nlohmann::json json = nlohmann::json::parse(in, nullptr, false);
+  if (json.is_discarded() || !json.is_object()) {
+    spdlog::error("解析地图{}失败", file.string());
+    return {};
+  }
+  try {
+    return parseTiledMap(context, json, file);
+  } catch (const nlohmann::json::exception &e) {
+    spdlog::error("地图{}格式错误 {}", file.string(), e.what());
+    return {};
+  }
+}
+
+} // namespace engine::render
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../resource_manager/handle.hpp"
+#include "SDL3/SDL_gpu.h"
+#include "camera.hpp"
+#include "pipelines/base.hpp"
+#include "tile.hpp"
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace engine::core {
+class Context;
+}
+
+namespace engine::resource {
+class Manager;
+}
+
+namespace engine::render {
+
+class Renderer;
+
+/*
+ * 按固定大小切分的图块集，图块编号从first_gid开始，0表示空
+ */
+struct Tileset {
+  // 整张图块集贴图，由资源管理器持有
+  engine::resource::TextureHandle texture;
+  // 贴图在图集页中的子区域，加载后不变
+  glm::vec4 region_uv{0.0f, 0.0f, 1.0f, 1.0f};
+  glm::vec2 image_size{0.0f, 0.0f};
+  glm::vec2 tile_size{0.0f, 0.0f};
+  uint32_t columns{1};
+  uint32_t count{0};
+  uint32_t margin{0};
+  uint32_t spacing{0};
+  uint32_t first_gid{1};
+
+  bool contains(uint32_t gid) const {
+    return gid >= first_gid && gid < first_gid + count;
+  }
+  // 图块在贴图中的uv子区域
+  glm::vec4 uv(uint32_t gid) const;
+};
+
+struct TilemapStats {
+  uint32_t chunks{0};
+  uint32_t visible_chunks{0};
+  // 本帧重新烘焙的区块
+  uint32_t baked_chunks{0};
+  uint32_t instances{0};
+};
+
+/*
+ * 静态瓦片地图的一层
+ * 按kChunkSize x kChunkSize切分成区块，每个区块的实例烘焙进自己的storage
+ * buffer，只有修改过的区块重新烘焙，只提交和相机相交的区块
+ * 坐标原点在地图左下角，第0行在最上面(和Tiled一致)
+ */
+class Tilemap final {
+public:
+  static constexpr uint32_t kChunkSize = 32;
+
+private:
+  struct Range {
+    uint32_t tileset;
+    uint32_t first;
+    uint32_t count;
+  };
+  struct Chunk {
+    SDL_GPUBuffer *buffer{nullptr};
+    uint32_t capacity{0};
+    // 按图块集分组的实例范围
+    std::vector<Range> ranges;
+    AABB bounds;
+    bool dirty{true};
+  };
+
+  Renderer *m_owner{nullptr};
+  engine::resource::Manager *m_resources{nullptr};
+  uint32_t m_width{0};
+  uint32_t m_height{0};
+  glm::vec2 m_tile_size{0.0f, 0.0f};
+  glm::vec2 m_origin{0.0f, 0.0f};
+  std::vector<uint32_t> m_tiles;
+  std::vector<Tileset> m_tilesets;
+  uint32_t m_chunks_x{0};
+  uint32_t m_chunks_y{0};
+  std::vector<Chunk> m_chunks;
+  uint8_t m_layer{0};
+  float m_depth{0.0f};
+  BlendMode m_blend{BlendMode::Alpha};
+  TilemapStats m_stats;
+  // 烘焙用的临时数组
+  std::vector<TileInfo> m_scratch;
+  // 每帧开始提交前从句柄取出的区域，贴图不可用时为空
+  std::vector<const TextureRegion *> m_regions;
+
+private:
+  void updateBounds();
+  bool bake(uint32_t cx, uint32_t cy, Chunk &chunk);
+  void markDirty(uint32_t x, uint32_t y);
+
+public:
+  Tilemap(engine::core::Context &context, uint32_t width, uint32_t height,
+          const glm::vec2 &tile_size);
+  ~Tilemap();
+
+  void addTileset(const Tileset &tileset);
+  // gid为0表示清空
+  void setTile(uint32_t x, uint32_t y, uint32_t gid);
+  uint32_t getTile(uint32_t x, uint32_t y) const;
+  void fill(const std::vector<uint32_t> &gids);
+
+  // 烘焙相交的脏区块后提交
+  void render(const AABB &view);
+
+  void setOrigin(const glm::vec2 &val);
+  const glm::vec2 &getOrigin() const { return m_origin; }
+  void setLayer(uint8_t layer) { m_layer = layer; }
+  uint8_t getLayer() const { return m_layer; }
+  void setDepth(float depth) { m_depth = depth; }
+  void setBlend(BlendMode blend) { m_blend = blend; }
+  uint32_t getWidth() const { return m_width; }
+  uint32_t getHeight() const { return m_height; }
+  AABB getBounds() const;
+  const TilemapStats &getStats() const { return m_stats; }
+
+  Tilemap(Tilemap &) = delete;
+  Tilemap(Tilemap &&) = delete;
+  Tilemap &operator=(Tilemap &) = delete;
+  Tilemap &operator=(Tilemap &&) = delete;
+};
+
+// 加载Tiled导出的json地图，每个tile layer一个Tilemap，层号按出现顺序
+std::vector<std::unique_ptr<Tilemap>> loadTiledMap(engine::core::Context &,
+                                                   std::string_view path);
+
+} // namespace engine::render
@@ -0,0 +1,276 @@
+#include "upload_ring.hpp"
+#include "SDL3/SDL_error.h"
+#include "SDL3/SDL_timer.h"
+#include "spdlog/spdlog.h"
+#include <cstring>
+
+namespace engine::render {
+
+namespace {
+constexpr uint64_t kAlignment = 16;
+} // namespace
+
+UploadRing::UploadRing(SDL_GPUDevice *device, uint32_t size)
+    : m_device{device}, m_size{size} {
+  SDL_GPUTransferBufferCreateInfo info{
+      .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+      .size = size,
+      .props = 0,
+  };
+  m_buffer = SDL_CreateGPUTransferBuffer(m_device, &info);
+  if (!m_buffer) {
+    spdlog::error("创建上传环失败{}", SDL_GetError());
+    m_size = 0;
+    return;
+  }
+  spdlog::trace("上传环初始化，大小{}", size);
+}
+
+UploadRing::~UploadRing() {
+  unmap();
+  for (auto &copy : m_pending) {
+    if (copy.owned) {
+      SDL_ReleaseGPUTransferBuffer(m_device, copy.source);
+    }
+  }
+  for (auto &flight : m_in_flight) {
+    SDL_ReleaseGPUFence(m_device, flight.fence);
+  }
+  if (m_buffer) {
+    SDL_ReleaseGPUTransferBuffer(m_device, m_buffer);
+    m_buffer = nullptr;
+  }
+}
+
+uint8_t *UploadRing::map() {
+  if (!m_mapped && m_buffer) {
+    // 不cycle，gpu正在读的区域由fence保证不会被覆盖
+    m_mapped = static_cast<uint8_t *>(
+        SDL_MapGPUTransferBuffer(m_device, m_buffer, false));
+  }
+  return m_mapped;
+}
+
+void UploadRing::unmap() {
+  if (m_mapped) {
+    SDL_UnmapGPUTransferBuffer(m_device, m_buffer);
+    m_mapped = nullptr;
+  }
+}
+
+void UploadRing::retire() {
+  while (!m_in_flight.empty() &&
+         SDL_QueryGPUFence(m_device, m_in_flight.front().fence)) {
+    m_tail = m_in_flight.front().end;
+    SDL_ReleaseGPUFence(m_device, m_in_flight.front().fence);
+    m_in_flight.pop_front();
+  }
+}
+
+void UploadRing::wait() {
+  uint64_t start = SDL_GetTicksNS();
+  m_stats.stalls++;
+  if (m_in_flight.empty()) {
+    flush();
+  }
+  if (!m_in_flight.empty()) {
+    SDL_GPUFence *fence = m_in_flight.front().fence;
+    SDL_WaitForGPUFences(m_device, true, &fence, 1);
+    retire();
+  }
+  m_stats.stall_time_ns += SDL_GetTicksNS() - start;
+}
+
+bool UploadRing::allocate(uint32_t size, uint32_t &offset) {
+  if (!m_buffer || size > m_size) {
+    return false;
+  }
+  uint64_t start = (m_head + kAlignment - 1) & ~(kAlignment - 1);
+  uint64_t pos = start % m_size;
+  // 不跨越环尾，剩下的部分跳过
+  if (pos + size > m_size) {
+    start += m_size - pos;
+    pos = 0;
+  }
+  while (start + size - m_tail > m_size) {
+    retire();
+    if (start + size - m_tail <= m_size) {
+      break;
+    }
+    if (m_in_flight.empty() && m_pending.empty()) {
+      // 全部回收后仍然放不下
+      return false;
+    }
+    spdlog::debug("上传环空间不足，等待gpu");
+    wait();
+  }
+  m_head = start + size;
+  offset = static_cast<uint32_t>(pos);
+  return true;
+}
+
+void UploadRing::push(const Copy &copy, const void *data, uint32_t size,
+                      uint32_t row_bytes, uint32_t pitch, uint32_t rows) {
+  Copy c = copy;
+  uint8_t *dst = nullptr;
+  uint32_t offset = 0;
+  if (size <= m_size / 2 && allocate(size, offset) && map()) {
+    c.source = m_buffer;
+    c.offset = offset;
+    dst = m_mapped + offset;
+  } else {
+    // 太大的上传单独创建transfer buffer
+    SDL_GPUTransferBufferCreateInfo info{
+        .usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD,
+        .size = size,
+        .props = 0,
+    };
+    c.source = SDL_CreateGPUTransferBuffer(m_device, &info);
+    if (!c.source) {
+      spdlog::error("创建transfer buffer失败{}", SDL_GetError());
+      return;
+    }
+    c.owned = true;
+    c.offset = 0;
+    dst = static_cast<uint8_t *>(
+        SDL_MapGPUTransferBuffer(m_device, c.source, false));
+    if (!dst) {
+      SDL_ReleaseGPUTransferBuffer(m_device, c.source);
+      return;
+    }
+  }
+
+  const auto *src = static_cast<const uint8_t *>(data);
+  if (row_bytes == pitch) {
+    std::memcpy(dst, src, size);
+  } else {
+    for (uint32_t row = 0; row < rows; row++) {
+      std::memcpy(dst + row * row_bytes, src + row * pitch, row_bytes);
+    }
+  }
+  if (c.owned) {
+    SDL_UnmapGPUTransferBuffer(m_device, c.source);
+  }
+
+  m_pending.push_back(c);
+  m_stats.bytes += size;
+  m_stats.uploads++;
+}
+
+bool UploadRing::uploadBuffer(SDL_GPUBuffer *buffer, uint32_t offset,
+                              const void *data, uint32_t size, bool cycle) {
+  if (!buffer || !data || size == 0) {
+    return false;
+  }
+  size_t before = m_pending.size();
+  push(Copy{.buffer = buffer, .dst_offset = offset, .size = size,
+            .cycle = cycle},
+       data, size, size, size, 1);
+  return m_pending.size() > before;
+}
+
+bool UploadRing::uploadTexture(SDL_GPUTexture *texture, uint32_t x,
+                               uint32_t y, uint32_t w, uint32_t h,
+                               const void *pixels, uint32_t pitch) {
+  if (!texture || !pixels || w == 0 || h == 0) {
+    return false;
+  }
+  size_t before = m_pending.size();
+  // 在环中按紧凑的行存放
+  uint32_t row_bytes = w * 4;
+  push(Copy{.texture = texture,
+            .size = row_bytes * h,
+            .x = x,
+            .y = y,
+            .w = w,
+            .h = h,
+            .pixels_per_row = w},
+       pixels, row_bytes * h, row_bytes, pitch, h);
+  return m_pending.size() > before;
+}
+
+void UploadRing::forget(SDL_GPUTexture *texture) {
+  std::erase_if(m_pending, [&](const Copy &copy) {
+    if (copy.texture != texture) {
+      return false;
+    }
+    if (copy.owned) {
+      SDL_ReleaseGPUTransferBuffer(m_device, copy.source);
+    }
+    return true;
+  });
+}
+
+void UploadRing::record(SDL_GPUCommandBuffer *cmd) {
+  if (m_pending.empty() || !cmd) {
+    return;
+  }
+  unmap();
+  SDL_GPUCopyPass *cp = SDL_BeginGPUCopyPass(cmd);
+  if (!cp) {
+    spdlog::error("begin copy pass失败{}", SDL_GetError());
+    return;
+  }
+  for (const auto &copy : m_pending) {
+    if (copy.buffer) {
+      SDL_GPUTransferBufferLocation tbl{
+          .transfer_buffer = copy.source,
+          .offset = copy.offset,
+      };
+      SDL_GPUBufferRegion br{
+          .buffer = copy.buffer,
+          .offset = copy.dst_offset,
+          .size = copy.size,
+      };
+      SDL_UploadToGPUBuffer(cp, &tbl, &br, copy.cycle);
+    } else {
+      SDL_GPUTextureTransferInfo tti{
+          .transfer_buffer = copy.source,
+          .offset = copy.offset,
+          .pixels_per_row = copy.pixels_per_row,
+          .rows_per_layer = copy.h,
+      };
+      SDL_GPUTextureRegion region{
+          .texture = copy.texture,
+          .mip_level = 0,
+          .layer = 0,
+          .x = copy.x,
+          .y = copy.y,
+          .z = 0,
+          .w = copy.w,
+          .h = copy.h,
+          .d = 1,
+      };
+      SDL_UploadToGPUTexture(cp, &tti, &region, copy.cycle);
+    }
+    if (copy.owned) {
+      // SDL在gpu用完后才真正释放
+      SDL_ReleaseGPUTransferBuffer(m_device, copy.source);
+    }
+  }
+  SDL_EndGPUCopyPass(cp);
+  m_pending.clear();
+  m_recorded = m_head;
+  m_stats.copy_passes++;
+}
+
+void UploadRing::submitted(SDL_GPUFence *fence) {
+  if (fence) {
+    m_in_flight.push_back(InFlight{.fence = fence, .end = m_recorded});
+  }
+}
+
+void UploadRing::flush() {
+  if (m_pending.empty()) {
+    return;
+  }
+  SDL_GPUCommandBuffer *cmd = SDL_AcquireGPUCommandBuffer(m_device);
+  if (!cmd) {
+    spdlog::error("请求command buffer失败{}", SDL_GetError());
+    return;
+  }
+  record(cmd);
+  submitted(SDL_SubmitGPUCommandBufferAndAcquireFence(cmd));
+}
+
+} // namespace engine::render
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "SDL3/SDL_gpu.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace engine::render {
+
+struct UploadStats {
+  uint64_t bytes{0};
+  uint32_t uploads{0};
+  uint32_t copy_passes{0};
+  // 空间不足时等待gpu的次数和时间
+  uint32_t stalls{0};
+  uint64_t stall_time_ns{0};
+};
+
+/*
+ * 常驻的上传环形缓冲
+ * 所有上传先写进环中的一段并记录拷贝命令，一帧内统一在一个copy pass中执行
+ * 每次提交带一个fence，gpu完成后回收对应的区域
+ */
+class UploadRing final {
+private:
+  struct Copy {
+    SDL_GPUTransferBuffer *source{nullptr};
+    uint32_t offset{0};
+    // 单独创建的transfer buffer，记录后释放
+    bool owned{false};
+    SDL_GPUBuffer *buffer{nullptr};
+    SDL_GPUTexture *texture{nullptr};
+    uint32_t dst_offset{0};
+    uint32_t size{0};
+    uint32_t x{0};
+    uint32_t y{0};
+    uint32_t w{0};
+    uint32_t h{0};
+    uint32_t pixels_per_row{0};
+    bool cycle{false};
+  };
+  struct InFlight {
+    SDL_GPUFence *fence;
+    // 该次提交之前写入的位置
+    uint64_t end;
+  };
+
+  SDL_GPUDevice *m_device{nullptr};
+  SDL_GPUTransferBuffer *m_buffer{nullptr};
+  uint32_t m_size{0};
+  uint8_t *m_mapped{nullptr};
+  // 单调递增的字节计数，取模得到环中的偏移
+  uint64_t m_head{0};
+  uint64_t m_tail{0};
+  // 已经记录进命令但还没有提交的位置
+  uint64_t m_recorded{0};
+
+  std::vector<Copy> m_pending;
+  std::deque<InFlight> m_in_flight;
+  UploadStats m_stats;
+
+private:
+  // 分配一段连续空间，返回环中的偏移
+  bool allocate(uint32_t size, uint32_t &offset);
+  uint8_t *map();
+  void unmap();
+  void wait();
+  void push(const Copy &copy, const void *data, uint32_t size,
+            uint32_t row_bytes, uint32_t pitch, uint32_t rows);
+
+public:
+  UploadRing(SDL_GPUDevice *device, uint32_t size = 32 * 1024 * 1024);
+  ~UploadRing();
+
+  bool uploadBuffer(SDL_GPUBuffer *buffer, uint32_t offset, const void *data,
+                    uint32_t size, bool cycle = false);
+  // pixels为rgba数据，pitch为每行字节数
+  bool uploadTexture(SDL_GPUTexture *texture, uint32_t x, uint32_t y,
+                     uint32_t w, uint32_t h, const void *pixels,
+                     uint32_t pitch);
+
+  // 贴图销毁前丢弃还没有记录的上传
+  void forget(SDL_GPUTexture *texture);
+
+  // 把所有待上传的数据记录到一个copy pass中，必须在render pass之外调用
+  void record(SDL_GPUCommandBuffer *cmd);
+  // 命令提交后用fence保护已记录的区域
+  void submitted(SDL_GPUFence *fence);
+  // 没有帧时自己提交一次
+  void flush();
+  // 回收gpu已经用完的区域
+  void retire();
+
+  bool hasPending() const { return !m_pending.empty(); }
+  const UploadStats &getStats() const { return m_stats; }
+
+  UploadRing(UploadRing &) = delete;
+  UploadRing(UploadRing &&) = delete;
+  UploadRing &operator=(UploadRing &) = delete;
+  UploadRing &operator=(UploadRing &&) = delete;
+};
+
+} // namespace engine::render
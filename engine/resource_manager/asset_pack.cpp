@@ -0,0 +1,298 @@
+#include "asset_pack.hpp"
+#include "../renderer/pipelines/base.hpp"
+#include "SDL3/SDL_error.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#ifdef TRIAL_HAS_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace engine::resource {
+
+std::string packNormalize(std::string_view path) {
+  return std::filesystem::path{path}.lexically_normal().generic_string();
+}
+
+uint64_t packHash(std::string_view normalized) {
+  return engine::render::hashValue(normalized, 14695981039346656037ull);
+}
+
+#ifdef _WIN32
+struct AssetPack::Mapping {
+  HANDLE file{INVALID_HANDLE_VALUE};
+  HANDLE mapping{nullptr};
+  void *view{nullptr};
+
+  ~Mapping() {
+    if (view) {
+      UnmapViewOfFile(view);
+    }
+    if (mapping) {
+      CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+      CloseHandle(file);
+    }
+  }
+
+  bool map(const std::string &path, size_t &size) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+      return false;
+    }
+    size = static_cast<size_t>(file_size.QuadPart);
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+      return false;
+    }
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    return view != nullptr;
+  }
+};
+#else
+struct AssetPack::Mapping {
+  void *view{nullptr};
+  size_t size{0};
+
+  ~Mapping() {
+    if (view) {
+      munmap(view, size);
+    }
+  }
+
+  bool map(const std::string &path, size_t &out_size) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      ::close(fd);
+      return false;
+    }
+    size = static_cast<size_t>(st.st_size);
+    void *ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // 映射建立后文件描述符不再需要
+    ::close(fd);
+    if (ptr == MAP_FAILED) {
+      return false;
+    }
+    view = ptr;
+    out_size = size;
+    return true;
+  }
+};
+#endif
+
+AssetPack::AssetPack() : m_mapping{std::make_unique<Mapping>()} {}
+AssetPack::~AssetPack() { spdlog::trace("资源包关闭"); }
+
+std::unique_ptr<AssetPack> AssetPack::open(std::string_view path) {
+  std::unique_ptr<AssetPack> ret{new AssetPack()};
+  std::string file{path};
+  if (!ret->m_mapping->map(file, ret->m_size)) {
+    spdlog::error("映射资源包{}失败", file);
+    return nullptr;
+  }
+  ret->m_data = static_cast<const uint8_t *>(ret->m_mapping->view);
+  if (!ret->validate()) {
+    spdlog::error("资源包{}格式错误", file);
+    return nullptr;
+  }
+  spdlog::trace("打开资源包{}，{}个条目，{}字节", file, ret->m_count,
+                ret->m_size);
+  return ret;
+}
+
+bool AssetPack::validate() {
+  if (m_size < sizeof(PackHeader)) {
+    return false;
+  }
+  PackHeader header;
+  std::memcpy(&header, m_data, sizeof(header));
+  if (header.magic != kPackMagic || header.version != kPackVersion) {
+    return false;
+  }
+  uint64_t index_size = uint64_t{header.count} * sizeof(PackEntry);
+  if (header.index_offset % alignof(PackEntry) != 0 ||
+      header.index_offset > m_size ||
+      index_size > m_size - header.index_offset) {
+    return false;
+  }
+  m_entries = reinterpret_cast<const PackEntry *>(m_data + header.index_offset);
+  m_count = header.count;
+  for (uint32_t i = 0; i < m_count; i++) {
+    const PackEntry &entry = m_entries[i];
+    if (entry.offset > m_size || entry.size > m_size - entry.offset ||
+        entry.name_offset > m_size ||
+        entry.name_size > m_size - entry.name_offset) {
+      return false;
+    }
+    if (!(entry.flags & kPackLz4) && entry.size != entry.raw_size) {
+      return false;
+    }
+    if (entry.type == PackType::Texture &&
+        uint64_t{entry.width} * entry.height * 4 != entry.raw_size) {
+      return false;
+    }
+  }
+  return true;
+}
+
+const PackEntry *AssetPack::find(std::string_view path) const {
+  std::string name = packNormalize(path);
+  uint64_t hash = packHash(name);
+  const PackEntry *begin = m_entries;
+  const PackEntry *end = m_entries + m_count;
+  auto it = std::lower_bound(
+      begin, end, hash,
+      [](const PackEntry &entry, uint64_t val) { return entry.hash < val; });
+  for (; it != end && it->hash == hash; it++) {
+    std::string_view stored{
+        reinterpret_cast<const char *>(m_data + it->name_offset),
+        it->name_size};
+    if (stored == name) {
+      return it;
+    }
+  }
+  return nullptr;
+}
+
+bool AssetPack::decode(const PackEntry &entry, uint8_t *dst) const {
+  const uint8_t *src = m_data + entry.offset;
+  if (!(entry.flags & kPackLz4)) {
+    std::memcpy(dst, src, entry.raw_size);
+    return true;
+  }
+#ifdef TRIAL_HAS_LZ4
+  int ret = LZ4_decompress_safe(reinterpret_cast<const char *>(src),
+                                reinterpret_cast<char *>(dst),
+                                static_cast<int>(entry.size),
+                                static_cast<int>(entry.raw_size));
+  if (ret != static_cast<int>(entry.raw_size)) {
+    spdlog::error("解压资源包条目失败");
+    return false;
+  }
+  m_decompressed_loads.fetch_add(1, std::memory_order_relaxed);
+  return true;
+#else
+  spdlog::error("资源包条目使用了LZ4压缩，但编译时没有LZ4");
+  return false;
+#endif
+}
+
+SDL_IOStream *AssetPack::openIO(std::string_view path) const {
+  const PackEntry *entry = find(path);
+  if (!entry) {
+    return nullptr;
+  }
+  if (!(entry->flags & kPackLz4)) {
+    m_mapped_loads.fetch_add(1, std::memory_order_relaxed);
+    return SDL_IOFromConstMem(m_data + entry->offset, entry->size);
+  }
+  std::vector<uint8_t> data(entry->raw_size);
+  if (!decode(*entry, data.data())) {
+    return nullptr;
+  }
+  // 解压后的数据交给SDL持有，关闭时释放
+  SDL_IOStream *io = SDL_IOFromDynamicMem();
+  if (!io) {
+    spdlog::error("创建内存流失败{}", SDL_GetError());
+    return nullptr;
+  }
+  if (SDL_WriteIO(io, data.data(), data.size()) != data.size() ||
+      SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) != 0) {
+    spdlog::error("写入内存流失败{}", SDL_GetError());
+    SDL_CloseIO(io);
+    return nullptr;
+  }
+  return io;
+}
+
+SDL_Surface *AssetPack::loadSurface(std::string_view path) const {
+  const PackEntry *entry = find(path);
+  if (!entry) {
+    return nullptr;
+  }
+  if (entry->type != PackType::Texture) {
+    spdlog::error("资源包条目{}不是贴图", path);
+    return nullptr;
+  }
+  auto w = static_cast<int>(entry->width);
+  auto h = static_cast<int>(entry->height);
+  if (!(entry->flags & kPackLz4)) {
+    // 只读映射，surface只用于上传和图集拷贝，不会被写入
+    m_mapped_loads.fetch_add(1, std::memory_order_relaxed);
+    return SDL_CreateSurfaceFrom(
+        w, h, SDL_PIXELFORMAT_ABGR8888,
+        const_cast<uint8_t *>(m_data + entry->offset), w * 4);
+  }
+  SDL_Surface *surface = SDL_CreateSurface(w, h, SDL_PIXELFORMAT_ABGR8888);
+  if (!surface) {
+    spdlog::error("创建surface失败{}", SDL_GetError());
+    return nullptr;
+  }
+  bool ok = false;
+  if (surface->pitch == w * 4) {
+    ok = decode(*entry, static_cast<uint8_t *>(surface->pixels));
+  } else {
+    std::vector<uint8_t> pixels(entry->raw_size);
+    ok = decode(*entry, pixels.data());
+    for (int y = 0; ok && y < h; y++) {
+      std::memcpy(static_cast<uint8_t *>(surface->pixels) +
+                      static_cast<size_t>(y) * surface->pitch,
+                  pixels.data() + static_cast<size_t>(y) * w * 4,
+                  static_cast<size_t>(w) * 4);
+    }
+  }
+  if (!ok) {
+    SDL_DestroySurface(surface);
+    return nullptr;
+  }
+  return surface;
+}
+
+bool AssetPack::read(std::string_view path, std::vector<uint8_t> &out) const {
+  const PackEntry *entry = find(path);
+  if (!entry) {
+    return false;
+  }
+  out.resize(entry->raw_size);
+  if (!(entry->flags & kPackLz4)) {
+    m_mapped_loads.fetch_add(1, std::memory_order_relaxed);
+  }
+  return decode(*entry, out.data());
+}
+
+AssetPackStats AssetPack::getStats() const {
+  return AssetPackStats{
+      .entries = m_count,
+      .size = m_size,
+      .mapped_loads = m_mapped_loads.load(std::memory_order_relaxed),
+      .decompressed_loads =
+          m_decompressed_loads.load(std::memory_order_relaxed),
+  };
+}
+
+} // namespace engine::resource
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "SDL3/SDL_iostream.h"
+#include "SDL3/SDL_surface.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace engine::resource {
+
+/*
+ * 资源包格式，所有字段小端
+ * [PackHeader][条目数据，16字节对齐][PackEntry索引，按hash排序][路径字符串]
+ */
+constexpr std::array<char, 4> kPackMagic{'T', 'R', 'P', 'K'};
+constexpr uint32_t kPackVersion = 1;
+constexpr uint32_t kPackAlign = 16;
+
+enum class PackType : uint32_t {
+  // 原样保存的文件，shader、音频、字体等
+  Raw,
+  // 预先解码成RGBA8(SDL_PIXELFORMAT_ABGR8888)的贴图，行间没有填充
+  Texture,
+};
+
+// 条目数据经过LZ4压缩
+constexpr uint32_t kPackLz4 = 1u << 0;
+
+struct PackHeader {
+  std::array<char, 4> magic;
+  uint32_t version;
+  uint32_t count;
+  uint32_t flags;
+  uint64_t index_offset;
+};
+
+struct PackEntry {
+  // 规范化路径的FNV-1a哈希
+  uint64_t hash;
+  uint64_t offset;
+  // 包中保存的字节数，压缩时小于raw_size
+  uint32_t size;
+  uint32_t raw_size;
+  PackType type;
+  uint32_t flags;
+  uint32_t width;
+  uint32_t height;
+  // 路径字符串，用于排除哈希冲突
+  uint32_t name_offset;
+  uint32_t name_size;
+};
+
+static_assert(sizeof(PackHeader) == 24);
+static_assert(sizeof(PackEntry) == 48);
+
+// 和打包工具使用相同的路径写法，"a/../b.png"和"b.png"是同一个条目
+std::string packNormalize(std::string_view path);
+uint64_t packHash(std::string_view normalized);
+
+struct AssetPackStats {
+  uint32_t entries{0};
+  uint64_t size{0};
+  // 直接引用映射内存的加载
+  uint32_t mapped_loads{0};
+  // 需要解压的加载
+  uint32_t decompressed_loads{0};
+};
+
+/*
+ * 只读映射的资源包
+ * 查找和读取不修改状态，可以在工作线程调用
+ * 没有压缩的条目直接引用映射的内存，资源包必须比使用它的资源活得久
+ */
+class AssetPack final {
+private:
+  struct Mapping;
+  std::unique_ptr<Mapping> m_mapping;
+  const uint8_t *m_data{nullptr};
+  size_t m_size{0};
+  const PackEntry *m_entries{nullptr};
+  uint32_t m_count{0};
+  mutable std::atomic<uint32_t> m_mapped_loads{0};
+  mutable std::atomic<uint32_t> m_decompressed_loads{0};
+
+private:
+  AssetPack();
+  bool validate();
+  // 解压或拷贝条目内容
+  bool decode(const PackEntry &entry, uint8_t *dst) const;
+
+public:
+  ~AssetPack();
+
+  // 映射资源包，失败时返回空
+  static std::unique_ptr<AssetPack> open(std::string_view path);
+
+  const PackEntry *find(std::string_view path) const;
+  bool contains(std::string_view path) const { return find(path) != nullptr; }
+
+  // 交给SDL的IO接口，调用者负责关闭，不在包中时返回空
+  SDL_IOStream *openIO(std::string_view path) const;
+  // 预解码的贴图，调用者负责销毁，不在包中时返回空
+  SDL_Surface *loadSurface(std::string_view path) const;
+  bool read(std::string_view path, std::vector<uint8_t> &out) const;
+
+  AssetPackStats getStats() const;
+
+  AssetPack(AssetPack &) = delete;
+  AssetPack(AssetPack &&) = delete;
+  AssetPack &operator=(AssetPack &) = delete;
+  AssetPack &operator=(AssetPack &&) = delete;
+};
+
+} // namespace engine::resource
@@ -1,6 +1,8 @@
 #include "audio_manager.hpp"
+#include "../core/profiler.hpp"
 #include "SDL3/SDL_error.h"
 #include "SDL3_mixer/SDL_mixer.h"
+#include "asset_pack.hpp"
 #include "spdlog/spdlog.h"
 #include <memory>
 #include <stdexcept>
@@ -20,7 +22,8 @@ Audio::~Audio() {
   Mix_Quit();
 }
 
-void Audio::init() {
+void Audio::init(const AssetPack *pack) {
+  m_pack = pack;
   MIX_InitFlags init_flag = MIX_INIT_MP3 | MIX_INIT_OGG;
   if (init_flag != (Mix_Init(init_flag) & init_flag)) {
     spdlog::error("音频管理器初始化失败{}", SDL_GetError());
@@ -34,57 +37,73 @@ void Audio::init() {
   spdlog::trace("音频管理器初始化");
 }
 
-Mix_Chunk *Audio::loadOrGetSound(const std::string &file) {
-  if (auto it = m_sound_map.find(file); it != m_sound_map.end()) {
-    return it->second.get();
+SoundHandle Audio::loadSound(const std::string &file) {
+  auto id = engine::core::StringId::intern(file);
+  if (auto it = m_sound_names.find(id); it != m_sound_names.end()) {
+    return it->second;
   }
 
-  Mix_Chunk *raw_chunk = Mix_LoadWAV(file.data());
+  TRIAL_PROFILE_ZONE("Audio::loadSound");
+  SDL_IOStream *io = m_pack ? m_pack->openIO(file) : nullptr;
+  Mix_Chunk *raw_chunk =
+      io ? Mix_LoadWAV_IO(io, true) : Mix_LoadWAV(file.data());
   if (raw_chunk == nullptr) {
     spdlog::error("加载音效失败");
-    return nullptr;
+    return {};
   }
   spdlog::trace("加载音效{}", file);
-  m_sound_map.emplace(file,
-                      std::unique_ptr<Mix_Chunk, SoundDestroyer>(raw_chunk));
-  return raw_chunk;
+  auto handle = m_sounds.insert(Sound{
+      .file = file,
+      .id = id,
+      .chunk = std::unique_ptr<Mix_Chunk, SoundDestroyer>(raw_chunk),
+  });
+  m_sound_names.emplace(id, handle);
+  return handle;
 }
 
-void Audio::removeSound(const std::string &file) {
-  if (auto it = m_sound_map.find(file); it != m_sound_map.end()) {
-    m_sound_map.erase(it);
+void Audio::removeSound(SoundHandle handle) {
+  if (const Sound *sound = m_sounds.get(handle)) {
+    m_sound_names.erase(sound->id);
+    m_sounds.remove(handle);
   }
 }
 
 void Audio::clearSounds() {
-  if (!m_sound_map.empty()) {
-    m_sound_map.clear();
-  }
+  m_sounds.clear();
+  m_sound_names.clear();
 }
 
-Mix_Music *Audio::loadOrGetMusic(const std::string &file) {
-  if (auto it = m_music_map.find(file); it != m_music_map.end()) {
-    return it->second.get();
+MusicHandle Audio::loadMusic(const std::string &file) {
+  auto id = engine::core::StringId::intern(file);
+  if (auto it = m_music_names.find(id); it != m_music_names.end()) {
+    return it->second;
   }
 
-  Mix_Music *raw_music = Mix_LoadMUS(file.data());
+  TRIAL_PROFILE_ZONE("Audio::loadMusic");
+  SDL_IOStream *io = m_pack ? m_pack->openIO(file) : nullptr;
+  Mix_Music *raw_music =
+      io ? Mix_LoadMUS_IO(io, true) : Mix_LoadMUS(file.data());
   if (raw_music == nullptr) {
     spdlog::error("加载音乐失败");
-    return nullptr;
+    return {};
   }
   spdlog::trace("加载音乐{}", file);
-  m_music_map.emplace(file,
-                      std::unique_ptr<Mix_Music, MusicDestroyer>(raw_music));
-  return raw_music;
+  auto handle = m_musics.insert(Music{
+      .file = file,
+      .id = id,
+      .music = std::unique_ptr<Mix_Music, MusicDestroyer>(raw_music),
+  });
+  m_music_names.emplace(id, handle);
+  return handle;
 }
-void Audio::removeMusic(const std::string &file) {
-  if (auto it = m_music_map.find(file); it != m_music_map.end()) {
-    m_music_map.erase(it);
+void Audio::removeMusic(MusicHandle handle) {
+  if (const Music *music = m_musics.get(handle)) {
+    m_music_names.erase(music->id);
+    m_musics.remove(handle);
   }
 }
 void Audio::clearMusics() {
-  if (!m_music_map.empty()) {
-    m_music_map.clear();
-  }
+  m_musics.clear();
+  m_music_names.clear();
 }
 } // namespace engine::resource
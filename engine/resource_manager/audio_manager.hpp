@@ -1,11 +1,15 @@
 #pragma once
 
+#include "../core/string_id.hpp"
 #include "SDL3_mixer/SDL_mixer.h"
+#include "handle.hpp"
 #include <memory>
 #include <string>
 #include <unordered_map>
 
 namespace engine::resource {
+class AssetPack;
+
 class Audio final {
 private:
   struct SoundDestroyer {
@@ -16,8 +20,16 @@ private:
       }
     }
   };
-  std::unordered_map<std::string, std::unique_ptr<Mix_Chunk, SoundDestroyer>>
-      m_sound_map;
+  struct Sound {
+    std::string file;
+    engine::core::StringId id;
+    std::unique_ptr<Mix_Chunk, SoundDestroyer> chunk;
+  };
+  SlotMap<Sound, SoundTag> m_sounds;
+  // 路径只在加载时查一次
+  std::unordered_map<engine::core::StringId, SoundHandle,
+                     engine::core::StringIdHash>
+      m_sound_names;
   struct MusicDestroyer {
     void operator()(Mix_Music *music) {
       if (music) {
@@ -26,21 +38,49 @@ private:
       }
     }
   };
-  std::unordered_map<std::string, std::unique_ptr<Mix_Music, MusicDestroyer>>
-      m_music_map;
+  struct Music {
+    std::string file;
+    engine::core::StringId id;
+    std::unique_ptr<Mix_Music, MusicDestroyer> music;
+  };
+  SlotMap<Music, MusicTag> m_musics;
+  std::unordered_map<engine::core::StringId, MusicHandle,
+                     engine::core::StringIdHash>
+      m_music_names;
+  // 不为空时优先从资源包加载，音乐播放时会持续读取包内的数据
+  const AssetPack *m_pack{nullptr};
 
 public:
   Audio();
   ~Audio();
 
-  void init();
+  void init(const AssetPack *pack = nullptr);
 
-  Mix_Chunk *loadOrGetSound(const std::string &);
-  void removeSound(const std::string &);
+  // 已加载时直接返回句柄，失败时返回空句柄
+  SoundHandle loadSound(const std::string &);
+  // 按路径的id查找已加载的音效，没有时返回空句柄
+  SoundHandle findSound(engine::core::StringId id) const {
+    auto it = m_sound_names.find(id);
+    return it != m_sound_names.end() ? it->second : SoundHandle{};
+  }
+  // 句柄失效时返回空
+  Mix_Chunk *getSound(SoundHandle handle) const {
+    const Sound *sound = m_sounds.get(handle);
+    return sound ? sound->chunk.get() : nullptr;
+  }
+  void removeSound(SoundHandle);
   void clearSounds();
 
-  Mix_Music *loadOrGetMusic(const std::string &);
-  void removeMusic(const std::string &);
+  MusicHandle loadMusic(const std::string &);
+  MusicHandle findMusic(engine::core::StringId id) const {
+    auto it = m_music_names.find(id);
+    return it != m_music_names.end() ? it->second : MusicHandle{};
+  }
+  Mix_Music *getMusic(MusicHandle handle) const {
+    const Music *music = m_musics.get(handle);
+    return music ? music->music.get() : nullptr;
+  }
+  void removeMusic(MusicHandle);
   void clearMusics();
 
   Audio(Audio &) = delete;
@@ -1,6 +1,8 @@
 #include "font_manager.hpp"
+#include "../core/profiler.hpp"
 #include "SDL3/SDL_error.h"
 #include "SDL3_ttf/SDL_ttf.h"
+#include "asset_pack.hpp"
 #include "spdlog/spdlog.h"
 #include <memory>
 #include <stdexcept>
@@ -15,7 +17,8 @@ Font::~Font() {
   }
 }
 
-void Font::init() {
+void Font::init(const AssetPack *pack) {
+  m_pack = pack;
   spdlog::trace("字体管理器初始化");
   if (!TTF_WasInit() && !TTF_Init()) {
     spdlog::trace("字体管理器初始化失败{}", SDL_GetError());
@@ -23,33 +26,42 @@ void Font::init() {
   }
 }
 
-TTF_Font *Font::getOrLoad(const std::string &file, uint32_t size) {
-  FontHashKey key{file, size};
-  if (auto it = m_map.find(key); it != m_map.end()) {
-    return it->second.get();
+FontHandle Font::load(const std::string &file, uint32_t size) {
+  FontHashKey key{engine::core::StringId::intern(file), size};
+  if (auto it = m_names.find(key); it != m_names.end()) {
+    return it->second;
   }
 
-  TTF_Font *raw_font = TTF_OpenFont(file.data(), static_cast<float>(size));
+  TRIAL_PROFILE_ZONE("Font::load");
+  // 每个字号各自打开一个流
+  SDL_IOStream *io = m_pack ? m_pack->openIO(file) : nullptr;
+  TTF_Font *raw_font =
+      io ? TTF_OpenFontIO(io, true, static_cast<float>(size))
+         : TTF_OpenFont(file.data(), static_cast<float>(size));
   if (raw_font == nullptr) {
     spdlog::error("打开字体文件失败{}", SDL_GetError());
-    return nullptr;
+    return {};
   }
   spdlog::trace("加载字体文件{} {}", file, size);
-  m_map.emplace(key, std::unique_ptr<TTF_Font, FontDestroyer>(raw_font));
-  return raw_font;
+  auto handle = m_fonts.insert(Entry{
+      .file = file,
+      .key = key,
+      .font = std::unique_ptr<TTF_Font, FontDestroyer>(raw_font),
+  });
+  m_names.emplace(std::move(key), handle);
+  return handle;
 }
 
-void Font::remove(const std::string &file, uint32_t size) {
-  FontHashKey key{file, size};
-  if (auto it = m_map.find(key); it != m_map.end()) {
-    spdlog::trace("移除字体文件{} {}", file, size);
-    m_map.erase(key);
+void Font::remove(FontHandle handle) {
+  if (const Entry *entry = m_fonts.get(handle)) {
+    spdlog::trace("移除字体文件{} {}", entry->file, entry->key.second);
+    m_names.erase(entry->key);
+    m_fonts.remove(handle);
   }
 }
 
 void Font::clear() {
-  if (!m_map.empty()) {
-    m_map.clear();
-  }
+  m_fonts.clear();
+  m_names.clear();
 }
 } // namespace engine::resource
@@ -1,23 +1,28 @@
 #pragma once
 
+#include "../core/string_id.hpp"
 #include "SDL3_ttf/SDL_ttf.h"
+#include "handle.hpp"
 #include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
 
-using FontHashKey = std::pair<std::string, uint32_t>;
+// 路径的id和字号
+using FontHashKey = std::pair<engine::core::StringId, uint32_t>;
 
 struct FontHashFun {
   std::size_t operator()(const FontHashKey &key) const {
-    std::hash<std::string> string_hash;
+    engine::core::StringIdHash id_hash;
     std::hash<uint32_t> int_hash;
-    return string_hash(key.first) ^ int_hash(key.second);
+    return id_hash(key.first) ^ int_hash(key.second);
   }
 };
 
 namespace engine::resource {
+class AssetPack;
+
 class Font final {
 private:
   struct FontDestroyer {
@@ -28,18 +33,36 @@ private:
       }
     }
   };
-  std::unordered_map<FontHashKey, std::unique_ptr<TTF_Font, FontDestroyer>,
-                     FontHashFun>
-      m_map;
+  struct Entry {
+    std::string file;
+    FontHashKey key;
+    std::unique_ptr<TTF_Font, FontDestroyer> font;
+  };
+  SlotMap<Entry, FontTag> m_fonts;
+  // 路径和字号只在加载时查一次
+  std::unordered_map<FontHashKey, FontHandle, FontHashFun> m_names;
+  // 不为空时优先从资源包加载
+  const AssetPack *m_pack{nullptr};
 
 public:
   Font();
   ~Font();
 
-  void init();
+  void init(const AssetPack *pack = nullptr);
 
-  TTF_Font *getOrLoad(const std::string &, uint32_t);
-  void remove(const std::string &, uint32_t);
+  // 已加载时直接返回句柄，失败时返回空句柄
+  FontHandle load(const std::string &, uint32_t);
+  // 按路径的id和字号查找已加载的字体，没有时返回空句柄
+  FontHandle find(engine::core::StringId id, uint32_t size) const {
+    auto it = m_names.find(FontHashKey{id, size});
+    return it != m_names.end() ? it->second : FontHandle{};
+  }
+  // 句柄失效时返回空
+  TTF_Font *get(FontHandle handle) const {
+    const Entry *entry = m_fonts.get(handle);
+    return entry ? entry->font.get() : nullptr;
+  }
+  void remove(FontHandle);
   void clear();
 
   Font(Font &) = delete;
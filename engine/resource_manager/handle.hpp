@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace engine::resource {
+
+/*
+ * 代数句柄，index指向槽位，槽位释放时generation加一
+ * 资源移除后旧句柄的generation对不上，查找返回空而不是悬空指针
+ */
+template <typename Tag> struct Handle {
+  uint32_t index{0};
+  // 0表示空句柄
+  uint32_t generation{0};
+
+  bool valid() const { return generation != 0; }
+  bool operator==(const Handle &) const = default;
+};
+
+struct TextureTag;
+struct SoundTag;
+struct MusicTag;
+struct FontTag;
+using TextureHandle = Handle<TextureTag>;
+using SoundHandle = Handle<SoundTag>;
+using MusicHandle = Handle<MusicTag>;
+using FontHandle = Handle<FontTag>;
+
+/*
+ * 槽位数组，插入、删除和按句柄查找都是O(1)
+ * 释放的槽位串成空闲链表复用，值在释放时重置为T{}
+ */
+template <typename T, typename Tag> class SlotMap final {
+private:
+  static constexpr uint32_t kNone = std::numeric_limits<uint32_t>::max();
+  struct Slot {
+    T value{};
+    uint32_t generation{1};
+    uint32_t next_free{kNone};
+    bool used{false};
+  };
+  std::vector<Slot> m_slots;
+  uint32_t m_free{kNone};
+  uint32_t m_size{0};
+
+public:
+  Handle<Tag> insert(T &&value) {
+    uint32_t index = m_free;
+    if (index != kNone) {
+      m_free = m_slots[index].next_free;
+    } else {
+      index = static_cast<uint32_t>(m_slots.size());
+      m_slots.emplace_back();
+    }
+    Slot &slot = m_slots[index];
+    slot.value = std::move(value);
+    slot.used = true;
+    slot.next_free = kNone;
+    m_size++;
+    return Handle<Tag>{.index = index, .generation = slot.generation};
+  }
+
+  T *get(Handle<Tag> handle) {
+    if (handle.index >= m_slots.size()) {
+      return nullptr;
+    }
+    Slot &slot = m_slots[handle.index];
+    return slot.used && slot.generation == handle.generation ? &slot.value
+                                                             : nullptr;
+  }
+  const T *get(Handle<Tag> handle) const {
+    return const_cast<SlotMap *>(this)->get(handle);
+  }
+
+  bool remove(Handle<Tag> handle) {
+    if (!get(handle)) {
+      return false;
+    }
+    Slot &slot = m_slots[handle.index];
+    slot.value = T{};
+    slot.used = false;
+    // 跳过0，空句柄永远不会匹配
+    if (++slot.generation == 0) {
+      slot.generation = 1;
+    }
+    slot.next_free = m_free;
+    m_free = handle.index;
+    m_size--;
+    return true;
+  }
+
+  // 回调参数为(Handle<Tag>, T &)
+  template <typename F> void forEach(F &&fn) {
+    for (uint32_t i = 0; i < m_slots.size(); i++) {
+      Slot &slot = m_slots[i];
+      if (slot.used) {
+        fn(Handle<Tag>{.index = i, .generation = slot.generation},
+           slot.value);
+      }
+    }
+  }
+
+  template <typename F> void forEach(F &&fn) const {
+    for (uint32_t i = 0; i < m_slots.size(); i++) {
+      const Slot &slot = m_slots[i];
+      if (slot.used) {
+        fn(Handle<Tag>{.index = i, .generation = slot.generation},
+           slot.value);
+      }
+    }
+  }
+
+  void clear() {
+    forEach([this](Handle<Tag> handle, T &) { remove(handle); });
+  }
+
+  uint32_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+};
+
+} // namespace engine::resource
@@ -11,49 +11,90 @@ namespace engine::resource {
 Manager::Manager() = default;
 Manager::~Manager() { spdlog::trace("资源管理器退出"); }
 
-void Manager::init(engine::render::Renderer &render) {
+void Manager::init(engine::render::Renderer &render,
+                   engine::core::ThreadPool &pool, const AssetPack *pack) {
   spdlog::trace("资源管理器初始化");
 
-  m_texture = std::make_unique<Texture>(render);
+  m_texture = std::make_unique<Texture>(render, pool, pack);
   m_audio = std::make_unique<Audio>();
-  m_audio->init();
+  m_audio->init(pack);
 
   m_font = std::make_unique<Font>();
-  m_font->init();
+  m_font->init(pack);
 }
 
-SDL_GPUTexture *Manager::textureGetOrLoad(const std::string &file) {
-  return m_texture->loadOrGet(file);
+TextureHandle Manager::textureLoad(const std::string &file) {
+  return m_texture->load(file);
 }
 
-void Manager::textureRemove(const std::string &file) {
-  m_texture->remove(file);
+TextureHandle Manager::textureLoadAsync(const std::string &file) {
+  return m_texture->loadAsync(file);
+}
+
+TextureHandle Manager::textureFind(engine::core::StringId id) const {
+  return m_texture->find(id);
+}
+
+uint32_t Manager::textureProcessLoaded() { return m_texture->processLoaded(); }
+
+void Manager::textureRemove(TextureHandle handle) {
+  m_texture->remove(handle);
 }
 
 void Manager::textureClear() { m_texture->clear(); }
 
-Mix_Chunk *Manager::soundGetOrLoad(const std::string &file) {
-  return m_audio->loadOrGetSound(file);
+void Manager::textureSetAtlasMode(bool enable) {
+  m_texture->setAtlasMode(enable);
 }
-void Manager::soundRemove(const std::string &file) {
-  m_audio->removeSound(file);
+
+void Manager::texturePrepack(const std::vector<std::string> &files) {
+  m_texture->prepack(files);
+}
+
+AtlasStats Manager::textureAtlasStats() const {
+  return m_texture->getAtlasStats();
 }
+
+void Manager::textureSetBudget(uint64_t bytes) { m_texture->setBudget(bytes); }
+
+const StreamingStats &Manager::textureStreamingStats() const {
+  return m_texture->getStreamingStats();
+}
+
+SoundHandle Manager::soundLoad(const std::string &file) {
+  return m_audio->loadSound(file);
+}
+SoundHandle Manager::soundFind(engine::core::StringId id) const {
+  return m_audio->findSound(id);
+}
+Mix_Chunk *Manager::soundGet(SoundHandle handle) const {
+  return m_audio->getSound(handle);
+}
+void Manager::soundRemove(SoundHandle handle) { m_audio->removeSound(handle); }
 void Manager::soundClear() { m_audio->clearSounds(); }
 
-Mix_Music *Manager::musicGetOrLoad(const std::string &file) {
-  return m_audio->loadOrGetMusic(file);
+MusicHandle Manager::musicLoad(const std::string &file) {
+  return m_audio->loadMusic(file);
 }
-void Manager::musicRemove(const std::string &file) {
-  m_audio->removeMusic(file);
+MusicHandle Manager::musicFind(engine::core::StringId id) const {
+  return m_audio->findMusic(id);
 }
+Mix_Music *Manager::musicGet(MusicHandle handle) const {
+  return m_audio->getMusic(handle);
+}
+void Manager::musicRemove(MusicHandle handle) { m_audio->removeMusic(handle); }
 void Manager::musicClear() { m_audio->clearMusics(); }
 
-TTF_Font *Manager::fontGetOrLoad(const std::string &file, uint32_t size) {
-  return m_font->getOrLoad(file, size);
+FontHandle Manager::fontLoad(const std::string &file, uint32_t size) {
+  return m_font->load(file, size);
+}
+FontHandle Manager::fontFind(engine::core::StringId id, uint32_t size) const {
+  return m_font->find(id, size);
 }
-void Manager::fontRemove(const std::string &file, uint32_t size) {
-  m_font->remove(file, size);
+TTF_Font *Manager::fontGet(FontHandle handle) const {
+  return m_font->get(handle);
 }
+void Manager::fontRemove(FontHandle handle) { m_font->remove(handle); }
 void Manager::fontClear() { m_font->clear(); }
 
 } // namespace engine::resource
@@ -4,19 +4,30 @@
 #include "SDL3/SDL_render.h"
 #include "SDL3_mixer/SDL_mixer.h"
 #include "SDL3_ttf/SDL_ttf.h"
+#include "handle.hpp"
 #include "texture_manager.hpp"
 #include <memory>
 #include <string>
+#include <vector>
 
 namespace engine::render {
 class Renderer;
 }
 
+namespace engine::core {
+class ThreadPool;
+}
+
 namespace engine::resource {
+class AssetPack;
 class Texture;
 class Audio;
 class Font;
 
+/*
+ * 路径只在加载时解析成句柄，之后按句柄O(1)查找
+ * 资源移除后旧句柄查找返回空
+ */
 class Manager final {
 private:
   std::unique_ptr<Texture> m_texture;
@@ -27,22 +38,50 @@ public:
   Manager();
   ~Manager();
 
-  void init(engine::render::Renderer &);
+  // pack不为空时优先从资源包加载，资源包需要比管理器活得久
+  void init(engine::render::Renderer &, engine::core::ThreadPool &,
+            const AssetPack *pack = nullptr);
 
-  SDL_GPUTexture *textureGetOrLoad(const std::string &);
-  void textureRemove(const std::string &);
+  TextureHandle textureLoad(const std::string &);
+  TextureHandle textureLoadAsync(const std::string &);
+  // 按路径的id查找已经加载过的资源，没有时返回空句柄
+  // 字面量路径在编译期转换成id，查找只比较整数
+  TextureHandle textureFind(engine::core::StringId) const;
+  // 未就绪、被驱逐或句柄失效时返回空，返回的区域只在本帧有效
+  // 只读，可以在工作线程调用
+  const engine::render::TextureRegion *textureGet(TextureHandle handle) const {
+    return m_texture->get(handle);
+  }
+  LoadState textureState(TextureHandle handle) const {
+    return m_texture->getState(handle);
+  }
+  // 每帧开始时调用，上传后台加载完成的贴图
+  uint32_t textureProcessLoaded();
+  void textureRemove(TextureHandle);
   void textureClear();
+  void textureSetAtlasMode(bool);
+  void texturePrepack(const std::vector<std::string> &);
+  AtlasStats textureAtlasStats() const;
+  // 贴图显存预算，0表示不限制
+  void textureSetBudget(uint64_t bytes);
+  const StreamingStats &textureStreamingStats() const;
 
-  Mix_Chunk *soundGetOrLoad(const std::string &);
-  void soundRemove(const std::string &);
+  SoundHandle soundLoad(const std::string &);
+  SoundHandle soundFind(engine::core::StringId) const;
+  Mix_Chunk *soundGet(SoundHandle) const;
+  void soundRemove(SoundHandle);
   void soundClear();
 
-  Mix_Music *musicGetOrLoad(const std::string &);
-  void musicRemove(const std::string &);
+  MusicHandle musicLoad(const std::string &);
+  MusicHandle musicFind(engine::core::StringId) const;
+  Mix_Music *musicGet(MusicHandle) const;
+  void musicRemove(MusicHandle);
   void musicClear();
 
-  TTF_Font *fontGetOrLoad(const std::string &, uint32_t);
-  void fontRemove(const std::string &, uint32_t);
+  FontHandle fontLoad(const std::string &, uint32_t);
+  FontHandle fontFind(engine::core::StringId, uint32_t) const;
+  TTF_Font *fontGet(FontHandle) const;
+  void fontRemove(FontHandle);
   void fontClear();
 
   Manager(Manager &) = delete;
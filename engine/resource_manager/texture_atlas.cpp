@@ -0,0 +1,362 @@
+#include "texture_atlas.hpp"
+#include "SDL3/SDL_error.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace engine::resource {
+
+/*********************** skyline ***********************/
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height)
+    : m_width{width}, m_height{height} {
+  reset();
+}
+
+void SkylinePacker::reset() {
+  m_nodes.clear();
+  m_nodes.push_back(Node{.x = 0, .y = 0, .w = m_width});
+  m_used_area = 0;
+}
+
+bool SkylinePacker::fit(size_t index, uint32_t w, uint32_t h,
+                        uint32_t &y) const {
+  uint32_t x = m_nodes[index].x;
+  if (x + w > m_width) {
+    return false;
+  }
+  y = m_nodes[index].y;
+  int64_t width_left = w;
+  for (size_t i = index; width_left > 0; i++) {
+    if (i >= m_nodes.size()) {
+      return false;
+    }
+    y = std::max(y, m_nodes[i].y);
+    if (y + h > m_height) {
+      return false;
+    }
+    width_left -= m_nodes[i].w;
+  }
+  return true;
+}
+
+void SkylinePacker::merge() {
+  for (size_t i = 0; i + 1 < m_nodes.size();) {
+    if (m_nodes[i].y == m_nodes[i + 1].y) {
+      m_nodes[i].w += m_nodes[i + 1].w;
+      m_nodes.erase(m_nodes.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+    } else {
+      i++;
+    }
+  }
+}
+
+std::optional<std::pair<uint32_t, uint32_t>>
+SkylinePacker::pack(uint32_t w, uint32_t h) {
+  if (w == 0 || h == 0) {
+    return std::nullopt;
+  }
+  // 选择放置后顶部最低的位置，相同时选更窄的节点
+  size_t best_index = m_nodes.size();
+  uint32_t best_top = UINT32_MAX;
+  uint32_t best_width = UINT32_MAX;
+  uint32_t best_y = 0;
+  for (size_t i = 0; i < m_nodes.size(); i++) {
+    uint32_t y;
+    if (!fit(i, w, h, y)) {
+      continue;
+    }
+    if (y + h < best_top || (y + h == best_top && m_nodes[i].w < best_width)) {
+      best_index = i;
+      best_top = y + h;
+      best_width = m_nodes[i].w;
+      best_y = y;
+    }
+  }
+  if (best_index == m_nodes.size()) {
+    return std::nullopt;
+  }
+
+  uint32_t x = m_nodes[best_index].x;
+  m_nodes.insert(m_nodes.begin() + static_cast<std::ptrdiff_t>(best_index),
+                 Node{.x = x, .y = best_y + h, .w = w});
+  // 裁掉被新节点覆盖的部分
+  for (size_t i = best_index + 1; i < m_nodes.size();) {
+    const Node &prev = m_nodes[i - 1];
+    uint32_t prev_right = prev.x + prev.w;
+    if (m_nodes[i].x >= prev_right) {
+      break;
+    }
+    uint32_t shrink = prev_right - m_nodes[i].x;
+    if (m_nodes[i].w <= shrink) {
+      m_nodes.erase(m_nodes.begin() + static_cast<std::ptrdiff_t>(i));
+      continue;
+    }
+    m_nodes[i].x += shrink;
+    m_nodes[i].w -= shrink;
+    break;
+  }
+  merge();
+  m_used_area += uint64_t{w} * h;
+  return std::make_pair(x, best_y);
+}
+
+/*********************** atlas ***********************/
+namespace {
+// 两个surface都是rgba格式，逐行拷贝
+void copySurface(const SDL_Surface *src, SDL_Surface *dst, uint32_t x,
+                 uint32_t y) {
+  auto *dst_pixels = static_cast<uint8_t *>(dst->pixels);
+  const auto *src_pixels = static_cast<const uint8_t *>(src->pixels);
+  size_t row_bytes = static_cast<size_t>(src->w) * 4;
+  for (int row = 0; row < src->h; row++) {
+    std::memcpy(dst_pixels + (y + row) * dst->pitch + x * 4,
+                src_pixels + row * src->pitch, row_bytes);
+  }
+}
+} // namespace
+
+TextureAtlas::TextureAtlas(engine::render::Renderer &render,
+                           uint32_t page_size)
+    : m_render{render}, m_page_size{page_size} {
+  spdlog::trace("图集初始化，页大小{}", page_size);
+}
+
+TextureAtlas::~TextureAtlas() { clear(); }
+
+engine::render::TextureRegion
+TextureAtlas::makeRegion(SDL_GPUTexture *texture, uint32_t x, uint32_t y,
+                         uint32_t w, uint32_t h) const {
+  float size = static_cast<float>(m_page_size);
+  return engine::render::TextureRegion{
+      .texture = texture,
+      .uv = glm::vec4{x / size, y / size, w / size, h / size},
+      .size = glm::vec2{static_cast<float>(w), static_cast<float>(h)},
+      .id = m_render.getTextureId(texture),
+  };
+}
+
+std::optional<uint32_t> TextureAtlas::newPage() {
+  SDL_GPUTexture *texture = m_render.createTexture(m_page_size, m_page_size);
+  if (!texture) {
+    spdlog::error("创建图集页失败{}", SDL_GetError());
+    return std::nullopt;
+  }
+  // 复用已经释放的页
+  for (uint32_t i = 0; i < m_pages.size(); i++) {
+    if (!m_pages[i].texture) {
+      m_pages[i].texture = texture;
+      m_pages[i].packer.reset();
+      m_pages[i].count = 0;
+      return i;
+    }
+  }
+  m_pages.push_back(Page{.texture = texture,
+                         .packer = SkylinePacker{m_page_size, m_page_size},
+                         .count = 0});
+  spdlog::trace("新建图集页{}", m_pages.size() - 1);
+  return static_cast<uint32_t>(m_pages.size() - 1);
+}
+
+void TextureAtlas::freePage(uint32_t page) {
+  Page &p = m_pages[page];
+  spdlog::trace("释放图集页{}", page);
+  m_render.destroyTexture(p.texture);
+  p.texture = nullptr;
+  p.packer.reset();
+  p.count = 0;
+}
+
+bool TextureAtlas::accept(const SDL_Surface *surface) const {
+  if (!surface) {
+    return false;
+  }
+  // 只收不超过半页的贴图，大贴图单独创建
+  uint32_t limit = m_page_size / 2;
+  return static_cast<uint32_t>(surface->w) <= limit &&
+         static_cast<uint32_t>(surface->h) <= limit;
+}
+
+std::optional<TextureAtlas::Entry>
+TextureAtlas::insert(const SDL_Surface *surface) {
+  if (!accept(surface)) {
+    return std::nullopt;
+  }
+  uint32_t w = static_cast<uint32_t>(surface->w);
+  uint32_t h = static_cast<uint32_t>(surface->h);
+
+  auto place = [&](uint32_t index) -> std::optional<Entry> {
+    Page &page = m_pages[index];
+    // 上传失败时恢复，否则占用的区域再也不能使用
+    SkylinePacker snapshot = page.packer;
+    auto pos = page.packer.pack(w + m_padding, h + m_padding);
+    if (!pos) {
+      return std::nullopt;
+    }
+    if (!m_render.uploadTexture(page.texture, surface, pos->first,
+                                pos->second)) {
+      page.packer = std::move(snapshot);
+      return std::nullopt;
+    }
+    page.count++;
+    return Entry{
+        .region = makeRegion(page.texture, pos->first, pos->second, w, h),
+        .page = index,
+    };
+  };
+
+  for (uint32_t i = 0; i < m_pages.size(); i++) {
+    if (!m_pages[i].texture) {
+      continue;
+    }
+    if (auto entry = place(i)) {
+      return entry;
+    }
+  }
+  auto index = newPage();
+  if (!index) {
+    return std::nullopt;
+  }
+  auto entry = place(*index);
+  if (!entry) {
+    freePage(*index);
+  }
+  return entry;
+}
+
+std::vector<std::optional<TextureAtlas::Entry>>
+TextureAtlas::packBatch(const std::vector<const SDL_Surface *> &surfaces) {
+  std::vector<std::optional<Entry>> ret(surfaces.size());
+
+  // 高的先放，skyline的浪费最少
+  std::vector<size_t> order(surfaces.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    const SDL_Surface *sa = surfaces[a];
+    const SDL_Surface *sb = surfaces[b];
+    int ha = sa ? sa->h : 0;
+    int hb = sb ? sb->h : 0;
+    if (ha != hb) {
+      return ha > hb;
+    }
+    return (sa ? sa->w : 0) > (sb ? sb->w : 0);
+  });
+
+  struct Placement {
+    size_t surface;
+    uint32_t x;
+    uint32_t y;
+  };
+  // 本批新建的页，先在cpu上拼好
+  std::vector<std::pair<uint32_t, std::vector<Placement>>> batch_pages;
+
+  for (size_t i : order) {
+    const SDL_Surface *surface = surfaces[i];
+    if (!accept(surface)) {
+      continue;
+    }
+    uint32_t w = static_cast<uint32_t>(surface->w) + m_padding;
+    uint32_t h = static_cast<uint32_t>(surface->h) + m_padding;
+    bool placed = false;
+    for (auto &[index, placements] : batch_pages) {
+      if (auto pos = m_pages[index].packer.pack(w, h)) {
+        placements.push_back(
+            Placement{.surface = i, .x = pos->first, .y = pos->second});
+        placed = true;
+        break;
+      }
+    }
+    if (placed) {
+      continue;
+    }
+    auto index = newPage();
+    if (!index) {
+      break;
+    }
+    auto pos = m_pages[*index].packer.pack(w, h);
+    if (!pos) {
+      freePage(*index);
+      continue;
+    }
+    batch_pages.push_back(
+        {*index, {Placement{.surface = i, .x = pos->first, .y = pos->second}}});
+  }
+
+  for (auto &[index, placements] : batch_pages) {
+    Page &page = m_pages[index];
+    SDL_Surface *page_surface = SDL_CreateSurface(
+        static_cast<int>(m_page_size), static_cast<int>(m_page_size),
+        SDL_PIXELFORMAT_ABGR8888);
+    if (!page_surface) {
+      spdlog::error("创建图集页surface失败{}", SDL_GetError());
+      freePage(index);
+      continue;
+    }
+    std::memset(page_surface->pixels, 0,
+                static_cast<size_t>(page_surface->pitch) * page_surface->h);
+    for (const auto &p : placements) {
+      copySurface(surfaces[p.surface], page_surface, p.x, p.y);
+    }
+    bool uploaded = m_render.uploadTexture(page.texture, page_surface);
+    SDL_DestroySurface(page_surface);
+    // 本批的页只有这些贴图，上传失败时整页释放
+    if (!uploaded) {
+      freePage(index);
+      continue;
+    }
+    for (const auto &p : placements) {
+      const SDL_Surface *surface = surfaces[p.surface];
+      page.count++;
+      ret[p.surface] = Entry{
+          .region = makeRegion(page.texture, p.x, p.y,
+                               static_cast<uint32_t>(surface->w),
+                               static_cast<uint32_t>(surface->h)),
+          .page = index,
+      };
+    }
+  }
+
+  AtlasStats stats = getStats();
+  spdlog::trace("预打包{}张贴图，图集页{}，填充率{:.1f}%", surfaces.size(),
+                stats.pages, stats.fill() * 100.0f);
+  return ret;
+}
+
+void TextureAtlas::release(uint32_t page) {
+  if (page >= m_pages.size() || !m_pages[page].texture) {
+    return;
+  }
+  Page &p = m_pages[page];
+  if (p.count > 0) {
+    p.count--;
+  }
+  if (p.count == 0) {
+    freePage(page);
+  }
+}
+
+void TextureAtlas::clear() {
+  for (auto &page : m_pages) {
+    if (page.texture) {
+      m_render.destroyTexture(page.texture);
+      page.texture = nullptr;
+    }
+  }
+  m_pages.clear();
+}
+
+AtlasStats TextureAtlas::getStats() const {
+  AtlasStats stats;
+  for (const auto &page : m_pages) {
+    if (!page.texture) {
+      continue;
+    }
+    stats.pages++;
+    stats.textures += page.count;
+    stats.used_pixels += page.packer.getUsedArea();
+    stats.total_pixels += page.packer.getArea();
+  }
+  return stats;
+}
+
+} // namespace engine::resource
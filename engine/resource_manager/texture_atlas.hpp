@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../renderer/renderer.hpp"
+#include "SDL3/SDL_surface.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace engine::resource {
+
+/*
+ * skyline装箱，bottom-left策略
+ */
+class SkylinePacker final {
+private:
+  struct Node {
+    uint32_t x;
+    uint32_t y;
+    uint32_t w;
+  };
+  uint32_t m_width{0};
+  uint32_t m_height{0};
+  uint64_t m_used_area{0};
+  std::vector<Node> m_nodes;
+
+private:
+  // 返回放在第index个节点上时的y，放不下返回false
+  bool fit(size_t index, uint32_t w, uint32_t h, uint32_t &y) const;
+  void merge();
+
+public:
+  SkylinePacker(uint32_t width, uint32_t height);
+
+  std::optional<std::pair<uint32_t, uint32_t>> pack(uint32_t w, uint32_t h);
+  void reset();
+
+  uint64_t getUsedArea() const { return m_used_area; }
+  uint64_t getArea() const { return uint64_t{m_width} * m_height; }
+};
+
+struct AtlasStats {
+  uint32_t pages{0};
+  uint32_t textures{0};
+  uint64_t used_pixels{0};
+  uint64_t total_pixels{0};
+
+  float fill() const {
+    return total_pixels ? static_cast<float>(used_pixels) / total_pixels
+                        : 0.0f;
+  }
+};
+
+/*
+ * 运行时图集，小贴图打包进大的图集页
+ */
+class TextureAtlas final {
+public:
+  struct Entry {
+    engine::render::TextureRegion region;
+    uint32_t page{0};
+  };
+
+private:
+  struct Page {
+    SDL_GPUTexture *texture{nullptr};
+    SkylinePacker packer;
+    uint32_t count{0};
+  };
+
+  engine::render::Renderer &m_render;
+  uint32_t m_page_size;
+  // 贴图之间留空，避免采样时串色
+  uint32_t m_padding{1};
+  std::vector<Page> m_pages;
+
+private:
+  engine::render::TextureRegion makeRegion(SDL_GPUTexture *texture,
+                                           uint32_t x, uint32_t y, uint32_t w,
+                                           uint32_t h) const;
+  std::optional<uint32_t> newPage();
+  // 销毁页的贴图，页槽位留给newPage复用
+  void freePage(uint32_t page);
+
+public:
+  TextureAtlas(engine::render::Renderer &render, uint32_t page_size = 2048);
+  ~TextureAtlas();
+
+  // 是否适合放进图集
+  bool accept(const SDL_Surface *surface) const;
+
+  // 增量插入，只上传贴图所在的子区域
+  std::optional<Entry> insert(const SDL_Surface *surface);
+
+  // 批量打包到新的图集页，每页只上传一次
+  std::vector<std::optional<Entry>>
+  packBatch(const std::vector<const SDL_Surface *> &surfaces);
+
+  // 图集页中的贴图全部移除后释放该页
+  void release(uint32_t page);
+  void clear();
+
+  AtlasStats getStats() const;
+  uint32_t getPageSize() const { return m_page_size; }
+
+  TextureAtlas(TextureAtlas &) = delete;
+  TextureAtlas(TextureAtlas &&) = delete;
+  TextureAtlas &operator=(TextureAtlas &) = delete;
+  TextureAtlas &operator=(TextureAtlas &&) = delete;
+};
+
+} // namespace engine::resource
@@ -1,52 +1,358 @@
 #include "texture_manager.hpp"
+#include "../core/mpsc_queue.hpp"
+#include "../core/profiler.hpp"
+#include "../core/thread_pool.hpp"
+#include "asset_pack.hpp"
 #include "SDL3/SDL_error.h"
 #include "spdlog/spdlog.h"
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace engine::resource {
-Texture::Texture(engine::render::Renderer &render) : m_render(render) {
+
+namespace {
+// 资源包中没有时回退到散文件，可以在工作线程调用
+SDL_Surface *loadSurface(const AssetPack *pack, const std::string &file) {
+  if (pack) {
+    if (SDL_Surface *surface = pack->loadSurface(file)) {
+      return surface;
+    }
+  }
+  return engine::render::Renderer::loadSurface(file);
+}
+} // namespace
+
+struct Texture::LoadQueue {
+  struct Loaded {
+    TextureHandle handle;
+    std::string file;
+    SDL_Surface *surface;
+  };
+  engine::core::MpscQueue<Loaded> queue;
+
+  ~LoadQueue() {
+    queue.drain([](Loaded &&loaded) {
+      if (loaded.surface) {
+        SDL_DestroySurface(loaded.surface);
+      }
+    });
+  }
+};
+
+Texture::Texture(engine::render::Renderer &render,
+                 engine::core::ThreadPool &pool, const AssetPack *pack)
+    : m_render(render), m_pool(pool), m_pack{pack},
+      m_loaded{std::make_shared<LoadQueue>()},
+      m_atlas{std::make_unique<TextureAtlas>(render)} {
   spdlog::trace("贴图管理器初始化");
 }
 Texture::~Texture() {
   spdlog::trace("贴图管理器退出");
-  // clear();
+  clear();
+}
+
+bool Texture::create(Entry &entry, const SDL_Surface *surface,
+                     bool allow_atlas) {
+  entry.region = {};
+  entry.page.reset();
+  entry.bytes = 0;
+  if (allow_atlas && m_atlas_mode) {
+    if (auto atlas_entry = m_atlas->insert(surface)) {
+      entry.region = atlas_entry->region;
+      entry.page = atlas_entry->page;
+    }
+  }
+  if (!entry.region.valid()) {
+    entry.region.texture = m_render.createTexture(surface);
+    entry.region.size = glm::vec2{static_cast<float>(surface->w),
+                                  static_cast<float>(surface->h)};
+    entry.region.id = m_render.getTextureId(entry.region.texture);
+    if (entry.region.valid()) {
+      entry.bytes = uint64_t{static_cast<uint32_t>(surface->w)} *
+                    static_cast<uint32_t>(surface->h) * 4;
+      m_resident_bytes += entry.bytes;
+    }
+  }
+  if (!entry.region.valid()) {
+    return false;
+  }
+  entry.state = LoadState::Ready;
+  return true;
 }
 
-SDL_GPUTexture *Texture::loadOrGet(const std::string &file) {
-  if (auto it = m_map.find(file); it != m_map.end()) {
+void Texture::destroy(Entry &entry) {
+  if (entry.page) {
+    m_atlas->release(*entry.page);
+  } else if (entry.region.texture) {
+    m_render.destroyTexture(entry.region.texture);
+    m_resident_bytes -= entry.bytes;
+  }
+  entry.region = {};
+  entry.page.reset();
+  entry.bytes = 0;
+}
+
+TextureHandle Texture::load(const std::string &file) {
+  auto id = engine::core::StringId::intern(file);
+  auto it = m_names.find(id);
+  Entry *entry = it != m_names.end() ? m_slots.get(it->second) : nullptr;
+  if (entry && entry->state == LoadState::Ready) {
     return it->second;
   }
 
-  SDL_GPUTexture *raw_texture = m_render.createTexture(file);
-  if (raw_texture == nullptr) {
+  TRIAL_PROFILE_ZONE("Texture::load");
+  SDL_Surface *surface = loadSurface(m_pack, file);
+  if (surface == nullptr) {
+    spdlog::error("获取贴图{}失败{}", file, SDL_GetError());
+    return {};
+  }
+  Entry loaded;
+  loaded.file = file;
+  loaded.id = id;
+  // 被驱逐过的贴图重新加载时不放进图集，保持uv不变
+  bool ok = create(loaded, surface, !entry || entry->bytes == 0);
+  SDL_DestroySurface(surface);
+  if (!ok) {
     spdlog::error("获取贴图{}失败{}", file, SDL_GetError());
-    return nullptr;
+    return {};
   }
   spdlog::trace("加载贴图{}", file);
-  m_map.emplace(file, raw_texture);
-  return raw_texture;
+  if (!entry) {
+    auto handle = m_slots.insert(std::move(loaded));
+    m_names.emplace(id, handle);
+    return handle;
+  }
+  if (entry->state == LoadState::Evicted) {
+    m_stats.reloads++;
+  }
+  // 同一贴图正在异步加载时直接完成它，后台结果到达后丢弃
+  *entry = std::move(loaded);
+  return it->second;
 }
 
-void Texture::remove(const std::string &file) {
-  if (auto it = m_map.find(file); it != m_map.end()) {
-    spdlog::trace("移除贴图{}", file);
-    if (it->second) {
-      m_render.destroyTexture(it->second);
-      it->second = nullptr;
-      m_map.erase(it);
+TextureHandle Texture::loadAsync(const std::string &file) {
+  auto id = engine::core::StringId::intern(file);
+  if (auto it = m_names.find(id); it != m_names.end()) {
+    Entry *entry = m_slots.get(it->second);
+    if (entry->state == LoadState::Evicted) {
+      entry->state = LoadState::Pending;
+      entry->wanted.value.store(false, std::memory_order_relaxed);
+      submitDecode(it->second, file);
+      m_stats.reloads++;
+    } else if (entry->state == LoadState::Failed) {
+      entry->state = LoadState::Pending;
+      submitDecode(it->second, file);
     }
+    return it->second;
   }
+
+  Entry entry;
+  entry.file = file;
+  entry.id = id;
+  auto handle = m_slots.insert(std::move(entry));
+  m_names.emplace(id, handle);
+  submitDecode(handle, file);
+  spdlog::trace("异步加载贴图{}", file);
+  return handle;
 }
 
-void Texture::clear() {
-  if (!m_map.empty()) {
-    for (auto &[name, val] : m_map) {
-      if (val) {
-        m_render.destroyTexture(val);
-        val = nullptr;
+void Texture::submitDecode(TextureHandle handle, const std::string &file) {
+  m_pool.submit([queue = m_loaded, pack = m_pack, handle, file] {
+    // 解码和格式转换不涉及gpu，可以在工作线程完成
+    TRIAL_PROFILE_ZONE("Texture::decode");
+    SDL_Surface *surface = loadSurface(pack, file);
+    queue->queue.push(LoadQueue::Loaded{
+        .handle = handle, .file = file, .surface = surface});
+  });
+}
+
+uint32_t Texture::processLoaded() {
+  TRIAL_PROFILE_ZONE("Texture::processLoaded");
+  size_t count = m_loaded->queue.drain([this](LoadQueue::Loaded &&loaded) {
+    Entry *entry = m_slots.get(loaded.handle);
+    if (!entry || entry->state != LoadState::Pending) {
+      // 已被移除或已同步加载，旧句柄的generation对不上
+      if (loaded.surface) {
+        SDL_DestroySurface(loaded.surface);
       }
+      return;
+    }
+    if (!loaded.surface) {
+      spdlog::error("异步加载贴图{}失败", loaded.file);
+      entry->state = LoadState::Failed;
+      return;
+    }
+    // 重新加载的贴图之前不在图集中
+    bool reload = entry->bytes != 0;
+    bool ok = create(*entry, loaded.surface, !reload);
+    SDL_DestroySurface(loaded.surface);
+    if (!ok) {
+      spdlog::error("创建贴图{}失败{}", loaded.file, SDL_GetError());
+      entry->state = LoadState::Failed;
+      return;
+    }
+    spdlog::trace("异步加载贴图{}完成", loaded.file);
+  });
+  reloadWanted();
+  evictCold();
+  m_stats.budget = m_budget;
+  m_stats.resident_bytes = residentBytes();
+  // 等待加载、失败和被驱逐的贴图不占显存
+  m_slots.forEach([this](TextureHandle, const Entry &entry) {
+    if (entry.state == LoadState::Ready) {
+      m_stats.resident_textures++;
     }
-    m_map.clear();
+  });
+  m_last_stats = m_stats;
+  m_stats = {};
+  return static_cast<uint32_t>(count);
+}
+
+void Texture::reloadWanted() {
+  std::erase_if(m_evicted, [this](TextureHandle handle) {
+    Entry *entry = m_slots.get(handle);
+    if (!entry || entry->state != LoadState::Evicted) {
+      // 已被移除或已重新加载
+      return true;
+    }
+    if (!entry->wanted.value.exchange(false, std::memory_order_relaxed)) {
+      return false;
+    }
+    spdlog::trace("重新加载贴图{}", entry->file);
+    entry->state = LoadState::Pending;
+    submitDecode(handle, entry->file);
+    m_stats.reloads++;
+    return true;
+  });
+}
+
+uint64_t Texture::residentBytes() const {
+  return m_resident_bytes + m_atlas->getStats().total_pixels * 4;
+}
+
+void Texture::evictCold() {
+  uint64_t resident = residentBytes();
+  if (m_budget == 0 || resident <= m_budget) {
+    return;
   }
+  struct Candidate {
+    uint64_t last_bound;
+    TextureHandle handle;
+  };
+  uint64_t frame = m_render.getFrameIndex();
+  std::vector<Candidate> cold;
+  m_slots.forEach([&](TextureHandle handle, const Entry &entry) {
+    // 图集页由多个贴图共享，不单独驱逐
+    if (entry.state != LoadState::Ready || entry.page) {
+      return;
+    }
+    uint64_t last = m_render.getTextureLastBound(entry.region.texture);
+    if (last + m_cold_frames <= frame) {
+      cold.push_back(Candidate{.last_bound = last, .handle = handle});
+    }
+  });
+  std::sort(cold.begin(), cold.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.last_bound < b.last_bound;
+            });
+  for (const auto &candidate : cold) {
+    if (resident <= m_budget) {
+      break;
+    }
+    Entry *entry = m_slots.get(candidate.handle);
+    resident -= entry->bytes;
+    spdlog::trace("驱逐贴图{}", entry->file);
+    // 释放由SDL延迟到gpu用完之后，保留bytes用来区分重新加载
+    m_render.destroyTexture(entry->region.texture);
+    m_resident_bytes -= entry->bytes;
+    entry->region = {};
+    entry->state = LoadState::Evicted;
+    m_evicted.push_back(candidate.handle);
+    m_stats.evictions++;
+  }
+  m_stats.over_budget = resident > m_budget;
+}
+
+uint32_t Texture::pendingCount() const {
+  uint32_t count = 0;
+  m_slots.forEach([&count](TextureHandle, const Entry &entry) {
+    if (entry.state == LoadState::Pending) {
+      count++;
+    }
+  });
+  return count;
+}
+
+void Texture::prepack(const std::vector<std::string> &files) {
+  TRIAL_PROFILE_ZONE("Texture::prepack");
+  std::vector<std::string> names;
+  std::vector<SDL_Surface *> surfaces;
+  for (const auto &file : files) {
+    if (auto it = m_names.find(engine::core::StringId::intern(file));
+        it != m_names.end() &&
+        m_slots.get(it->second)->state != LoadState::Failed) {
+      continue;
+    }
+    SDL_Surface *surface = loadSurface(m_pack, file);
+    if (!surface) {
+      spdlog::error("预打包贴图{}失败", file);
+      continue;
+    }
+    names.push_back(file);
+    surfaces.push_back(surface);
+  }
+
+  std::vector<const SDL_Surface *> view(surfaces.begin(), surfaces.end());
+  auto entries = m_atlas->packBatch(view);
+  for (size_t i = 0; i < names.size(); i++) {
+    TextureHandle handle;
+    auto id = engine::core::StringId::intern(names[i]);
+    if (auto it = m_names.find(id); it != m_names.end()) {
+      handle = it->second;
+    } else {
+      Entry entry;
+      entry.file = names[i];
+      entry.id = id;
+      handle = m_slots.insert(std::move(entry));
+      m_names.emplace(id, handle);
+    }
+    Entry *entry = m_slots.get(handle);
+    bool ok = false;
+    if (entries[i]) {
+      entry->region = entries[i]->region;
+      entry->page = entries[i]->page;
+      entry->state = LoadState::Ready;
+      ok = true;
+    } else {
+      // 放不进图集的大贴图单独创建
+      ok = create(*entry, surfaces[i], false);
+    }
+    SDL_DestroySurface(surfaces[i]);
+    if (!ok) {
+      entry->state = LoadState::Failed;
+    }
+  }
+}
+
+void Texture::remove(TextureHandle handle) {
+  Entry *entry = m_slots.get(handle);
+  if (!entry) {
+    return;
+  }
+  spdlog::trace("移除贴图{}", entry->file);
+  destroy(*entry);
+  m_names.erase(entry->id);
+  // 之后旧句柄查找都返回空
+  m_slots.remove(handle);
+}
+
+void Texture::clear() {
+  m_slots.forEach([this](TextureHandle, Entry &entry) { destroy(entry); });
+  m_slots.clear();
+  m_names.clear();
+  m_evicted.clear();
 }
 
 } // namespace engine::resource
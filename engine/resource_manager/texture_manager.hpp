@@ -1,26 +1,162 @@
 #pragma once
 
+#include "../core/string_id.hpp"
 #include "../renderer/renderer.hpp"
 #include "glm/glm.hpp"
+#include "handle.hpp"
+#include "texture_atlas.hpp"
+#include <atomic>
 #include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+namespace engine::core {
+class ThreadPool;
+}
 
 namespace engine::resource {
+
+class AssetPack;
+
+// Evicted: 超出显存预算被驱逐，再次get()之后重新加载
+enum class LoadState : uint8_t { Pending, Ready, Failed, Evicted };
+
+// 每帧的贴图驻留统计
+struct StreamingStats {
+  // 0表示不限制
+  uint64_t budget{0};
+  // 独立贴图和图集页占用的显存
+  uint64_t resident_bytes{0};
+  uint32_t resident_textures{0};
+  uint32_t evictions{0};
+  uint32_t reloads{0};
+  // 超出预算，但剩下的贴图最近都用过，无法驱逐
+  bool over_budget{false};
+};
+
 class Texture final {
 private:
+  // 槽位移动只发生在主线程加载时，渲染线程只会置位
+  struct RequestFlag {
+    mutable std::atomic<bool> value{false};
+
+    RequestFlag() = default;
+    RequestFlag(const RequestFlag &other)
+        : value{other.value.load(std::memory_order_relaxed)} {}
+    RequestFlag &operator=(const RequestFlag &other) {
+      value.store(other.value.load(std::memory_order_relaxed),
+                  std::memory_order_relaxed);
+      return *this;
+    }
+  };
+  struct Entry {
+    std::string file;
+    engine::core::StringId id;
+    LoadState state{LoadState::Pending};
+    engine::render::TextureRegion region;
+    // 在图集中时为所在页，否则独占一张贴图
+    std::optional<uint32_t> page;
+    // 独占贴图的显存，在图集中时为0
+    // 被驱逐后保留，重新加载时据此不放进图集，uv保持不变
+    uint64_t bytes{0};
+    // 被驱逐后又需要绘制
+    RequestFlag wanted;
+  };
+  // 工作线程解码完成的surface，和任务共享，管理器先析构也不会悬空
+  struct LoadQueue;
+
   engine::render::Renderer &m_render;
-  // TODO 封装成智能指针？
-  std::unordered_map<std::string, SDL_GPUTexture *> m_map;
+  engine::core::ThreadPool &m_pool;
+  // 不为空时优先从资源包加载
+  const AssetPack *m_pack{nullptr};
+  SlotMap<Entry, TextureTag> m_slots;
+  // 路径只在加载时查一次
+  std::unordered_map<engine::core::StringId, TextureHandle,
+                     engine::core::StringIdHash>
+      m_names;
+  std::shared_ptr<LoadQueue> m_loaded;
+  std::unique_ptr<TextureAtlas> m_atlas;
+  bool m_atlas_mode{false};
+  // 被驱逐的贴图，句柄不变，再次使用时重新加载
+  std::vector<TextureHandle> m_evicted;
+  uint64_t m_budget{0};
+  // 最近这么多帧内绑定过的贴图不驱逐
+  uint32_t m_cold_frames{30};
+  uint64_t m_resident_bytes{0};
+  StreamingStats m_stats;
+  StreamingStats m_last_stats;
+
+private:
+  // 根据surface创建贴图，allow_atlas时放进图集
+  bool create(Entry &, const SDL_Surface *, bool allow_atlas);
+  void destroy(Entry &);
+  // 在工作线程解码，完成后由processLoaded创建贴图
+  void submitDecode(TextureHandle, const std::string &);
+  // 重新提交被请求的驱逐贴图
+  void reloadWanted();
+  // 超出预算时按最后绑定的帧号从旧到新驱逐
+  void evictCold();
+  uint64_t residentBytes() const;
 
 public:
-  Texture(engine::render::Renderer &render);
+  Texture(engine::render::Renderer &render, engine::core::ThreadPool &pool,
+          const AssetPack *pack = nullptr);
   ~Texture();
 
-  SDL_GPUTexture *loadOrGet(const std::string &);
-  void remove(const std::string &);
+  // 同步加载，已加载时直接返回句柄，失败时返回空句柄
+  TextureHandle load(const std::string &);
+  // 在工作线程解码，句柄在processLoaded之后变为可用
+  TextureHandle loadAsync(const std::string &);
+  // 按路径的id查找已加载或正在加载的贴图，没有时返回空句柄
+  TextureHandle find(engine::core::StringId id) const {
+    auto it = m_names.find(id);
+    return it != m_names.end() ? it->second : TextureHandle{};
+  }
+  // 主线程每帧开始时调用，把解码完成的贴图交给上传环，返回处理的数量
+  // 同时重新加载被请求的驱逐贴图，超出预算时驱逐冷贴图
+  uint32_t processLoaded();
+
+  // 句柄失效、还在加载或被驱逐时返回空，被驱逐时请求重新加载
+  // 返回的区域只在本帧有效，只读，可以在工作线程调用
+  const engine::render::TextureRegion *get(TextureHandle handle) const {
+    const Entry *entry = m_slots.get(handle);
+    if (!entry) {
+      return nullptr;
+    }
+    if (entry->state == LoadState::Ready) {
+      return &entry->region;
+    }
+    if (entry->state == LoadState::Evicted) {
+      entry->wanted.value.store(true, std::memory_order_relaxed);
+    }
+    return nullptr;
+  }
+  // 句柄失效时返回Failed
+  LoadState getState(TextureHandle handle) const {
+    const Entry *entry = m_slots.get(handle);
+    return entry ? entry->state : LoadState::Failed;
+  }
+  uint32_t pendingCount() const;
+  void remove(TextureHandle);
   void clear();
 
+  // 图集模式下小贴图会打包进图集页
+  void setAtlasMode(bool enable) { m_atlas_mode = enable; }
+  bool isAtlasMode() const { return m_atlas_mode; }
+  // 一次性打包一组贴图，避免增量插入时多次上传
+  void prepack(const std::vector<std::string> &);
+  AtlasStats getAtlasStats() const { return m_atlas->getStats(); }
+
+  // 显存预算，0表示不限制，只驱逐独立贴图
+  void setBudget(uint64_t bytes, uint32_t cold_frames = 30) {
+    m_budget = bytes;
+    m_cold_frames = cold_frames;
+  }
+  // 上一帧的统计
+  const StreamingStats &getStreamingStats() const { return m_last_stats; }
+
   Texture(Texture &) = delete;
   Texture(Texture &&) = delete;
   Texture &operator=(Texture &) = delete;
@@ -1,8 +1,10 @@
 #include "manager.hpp"
 #include "../core/context.hpp"
+#include "../core/profiler.hpp"
 
 namespace engine::scene {
 void Manager::render() {
+  TRIAL_PROFILE_ZONE("scene::Manager::render");
   if (!m_scenes.empty()) {
     for (const auto &scene : m_scenes) {
       scene->render(m_context);
@@ -11,6 +13,7 @@ void Manager::render() {
 }
 
 void Manager::update(float dt) {
+  TRIAL_PROFILE_ZONE("scene::Manager::update");
   if (!m_scenes.empty()) {
     auto &last_scene = m_scenes.back();
     last_scene->update(dt, m_context);
@@ -19,6 +22,7 @@ void Manager::update(float dt) {
 }
 
 void Manager::event() {
+  TRIAL_PROFILE_ZONE("scene::Manager::event");
   // 只考虑顶层
   if (!m_scenes.empty()) {
     auto &last_scene = m_scenes.back();
@@ -38,6 +38,11 @@ public:
   void update(float);
   void event();
 
+  // 顶层场景，没有场景时返回空
+  const Scene *top() const {
+    return m_scenes.empty() ? nullptr : m_scenes.back().get();
+  }
+
   void push(std::unique_ptr<Scene> &&);
   void replace(std::unique_ptr<Scene> &&);
   void pop();
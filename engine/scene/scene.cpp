@@ -1,24 +1,143 @@
 #include "scene.hpp"
+#include "../core/thread_pool.hpp"
+#include "../object/systems.hpp"
 #include "spdlog/spdlog.h"
 #include <algorithm>
 #include <memory>
 
 namespace engine::scene {
+namespace {
+// 同名对象保持加入顺序，标签内的顺序不重要
+bool eraseFrom(std::vector<engine::object::Object *> &objs,
+               engine::object::Object *obj, bool keep_order) {
+  auto it = std::find(objs.begin(), objs.end(), obj);
+  if (it == objs.end()) {
+    return false;
+  }
+  if (keep_order) {
+    objs.erase(it);
+  } else {
+    *it = objs.back();
+    objs.pop_back();
+  }
+  return true;
+}
+} // namespace
+
 void Scene::processPending() {
   if (!m_pending.empty()) {
     for (auto &obj : m_pending) {
+      index(obj.get());
       m_objs.push_back(std::move(obj));
     }
     m_pending.clear();
   }
 }
 
-void Scene::addObj(std::unique_ptr<engine::object::Object> &&obj) {
+void Scene::index(engine::object::Object *obj) {
+  m_name_index[obj->getId()].push_back(obj);
+  for (auto tag : obj->getTags()) {
+    m_tag_index[tag].push_back(obj);
+  }
+}
+
+void Scene::unindex(engine::object::Object *obj) {
+  if (auto it = m_name_index.find(obj->getId()); it != m_name_index.end()) {
+    eraseFrom(it->second, obj, true);
+    if (it->second.empty()) {
+      m_name_index.erase(it);
+    }
+  }
+  for (auto tag : obj->getTags()) {
+    if (auto it = m_tag_index.find(tag); it != m_tag_index.end()) {
+      eraseFrom(it->second, obj, false);
+      if (it->second.empty()) {
+        m_tag_index.erase(it);
+      }
+    }
+  }
+}
+
+void Scene::release(engine::object::Object *obj) {
   if (obj) {
-    m_pending.push_back(std::move(obj));
+    unindex(obj);
+    m_handles.remove(obj->m_handle);
+    obj->m_handle = {};
+  }
+}
+
+void Scene::compactObjs() {
+  if (m_remove_policy == RemovePolicy::Stable) {
+    size_t kept = 0;
+    for (size_t i = 0; i < m_objs.size(); i++) {
+      auto &obj = m_objs[i];
+      if (!obj || obj->needRemove()) {
+        release(obj.get());
+        obj.reset();
+        continue;
+      }
+      obj->savePrevious();
+      if (kept != i) {
+        m_objs[kept] = std::move(obj);
+      }
+      kept++;
+    }
+    m_objs.erase(m_objs.begin() + kept, m_objs.end());
   } else {
+    for (size_t i = 0; i < m_objs.size();) {
+      auto &obj = m_objs[i];
+      if (obj && !obj->needRemove()) {
+        obj->savePrevious();
+        i++;
+        continue;
+      }
+      // 换过来的对象还没有检查，i不前进
+      release(obj.get());
+      obj = std::move(m_objs.back());
+      m_objs.pop_back();
+    }
+  }
+}
+
+bool Scene::isIndexed(engine::object::Object *obj) const {
+  auto it = m_name_index.find(obj->getId());
+  return it != m_name_index.end() &&
+         std::find(it->second.begin(), it->second.end(), obj) !=
+             it->second.end();
+}
+
+engine::object::ObjectHandle Scene::addObj(engine::object::ObjectPtr &&obj) {
+  if (!obj) {
     spdlog::warn("尝试添加空对象");
+    return {};
+  }
+  if (obj->m_handle.valid()) {
+    spdlog::warn("对象{}已经在场景中", obj->getName());
+    return obj->m_handle;
+  }
+  obj->m_handle = m_handles.insert(obj.get());
+  m_pending.push_back(std::move(obj));
+  return m_pending.back()->m_handle;
+}
+
+void Scene::addTilemap(std::unique_ptr<engine::render::Tilemap> &&tilemap) {
+  if (tilemap) {
+    m_tilemaps.push_back(std::move(tilemap));
+  } else {
+    spdlog::warn("尝试添加空地图");
+  }
+}
+
+bool Scene::loadTiledMap(engine::core::Context &context,
+                         std::string_view path) {
+  auto tilemaps = engine::render::loadTiledMap(context, path);
+  if (tilemaps.empty()) {
+    return false;
+  }
+  for (auto &tilemap : tilemaps) {
+    addTilemap(std::move(tilemap));
   }
+  return true;
 }
 
 void Scene::removeObj(engine::object::Object *obj) {
@@ -26,20 +145,73 @@ void Scene::removeObj(engine::object::Object *obj) {
     obj->setRemove();
 }
 
-engine::object::Object *Scene::getObjByName(const std::string &name) const {
-  auto it =
-      std::find_if(m_objs.begin(), m_objs.end(),
-                   [name](const std::unique_ptr<engine::object::Object> &obj) {
-                     return name == obj->getName();
-                   });
-  if (it != m_objs.end()) {
-    return (*it).get();
+void Scene::removeObj(engine::object::ObjectHandle handle) {
+  removeObj(getObj(handle));
+}
+
+engine::object::Object *
+Scene::getObj(engine::object::ObjectHandle handle) const {
+  auto obj = m_handles.get(handle);
+  return obj ? *obj : nullptr;
+}
+
+engine::object::Object *Scene::getObjByName(engine::core::StringId id) const {
+  auto it = m_name_index.find(id);
+  return it != m_name_index.end() ? it->second.front() : nullptr;
+}
+
+engine::object::ObjectHandle
+Scene::findObj(engine::core::StringId id) const {
+  auto obj = getObjByName(id);
+  return obj ? obj->getHandle() : engine::object::ObjectHandle{};
+}
+
+const std::vector<engine::object::Object *> &
+Scene::getObjsByTag(engine::core::StringId tag) const {
+  static const std::vector<engine::object::Object *> kEmpty;
+  auto it = m_tag_index.find(tag);
+  return it != m_tag_index.end() ? it->second : kEmpty;
+}
+
+void Scene::renameObj(engine::object::Object *obj, const std::string &name) {
+  if (!obj) {
+    return;
+  }
+  // 还在m_pending中的对象进入场景时才建立索引
+  bool indexed = isIndexed(obj);
+  if (indexed) {
+    unindex(obj);
+  }
+  obj->setName(name);
+  if (indexed) {
+    index(obj);
   }
-  return nullptr;
 }
 
-void Scene::removeObjByName(const std::string &name) {
-  auto obj = getObjByName(name);
+void Scene::tagObj(engine::object::Object *obj, engine::core::StringId tag) {
+  if (!obj || obj->hasTag(tag)) {
+    return;
+  }
+  obj->addTag(tag);
+  if (isIndexed(obj)) {
+    m_tag_index[tag].push_back(obj);
+  }
+}
+
+void Scene::untagObj(engine::object::Object *obj, engine::core::StringId tag) {
+  if (!obj || !obj->removeTag(tag)) {
+    return;
+  }
+  if (auto it = m_tag_index.find(tag); it != m_tag_index.end()) {
+    eraseFrom(it->second, obj, false);
+    if (it->second.empty()) {
+      m_tag_index.erase(it);
+    }
+  }
+}
+
+void Scene::removeObjByName(engine::core::StringId id) {
+  auto obj = getObjByName(id);
   if (obj)
     removeObj(obj);
 }
@@ -49,28 +221,101 @@ void Scene::init(engine::core::Context &) {
   spdlog::trace("场景{}初始化成功", m_name);
 }
 
-void Scene::update(float dt [[maybe_unused]],
-                   engine::core::Context &context [[maybe_unused]]) {
+void Scene::update(float dt, engine::core::Context &context [[maybe_unused]]) {
+  TRIAL_PROFILE_ZONE("Scene::update");
   // 调用对象跟新
-  for (auto it = m_objs.begin(); it != m_objs.end();) {
-    if (*it) {
-      // 安全的删除对象
-      if ((*it)->needRemove()) {
-        it = m_objs.erase(it);
-      } else {
-        //  (*it)->update(dt);
-        it++;
-      }
+  compactObjs();
+  processPending();
+  engine::object::savePrevious(m_world);
+  engine::object::integrate(m_world, dt);
+  // 遍历结束后才改变实体的结构
+  m_commands.apply(m_world);
+}
+
+void Scene::buildSegment(const engine::render::AABB &view, uint32_t begin,
+                         uint32_t end, engine::render::SpriteSegment &segment) {
+  TRIAL_PROFILE_ZONE("Scene::buildSegment");
+  segment.clear();
+  for (uint32_t i = begin; i < end; i++) {
+    const auto &obj = m_objs[i];
+    auto bounds = obj->getBounds();
+    if (bounds && !bounds->intersects(view)) {
+      segment.culled++;
+      continue;
     }
+    obj->render(segment);
+    segment.visible++;
   }
-  processPending();
 }
 
-void Scene::render(engine::core::Context &context [[maybe_unused]]) {
+void Scene::render(engine::core::Context &context) {
+  TRIAL_PROFILE_ZONE("Scene::render");
+  auto &renderer = context.getRenderer();
+  // 不在相机范围内的对象不提交，省掉排序和上传
+  engine::render::AABB view = renderer.getCamera().getViewBounds();
+  // 瓦片地图按区块剔除
+  for (const auto &tilemap : m_tilemaps) {
+    tilemap->render(view);
+  }
+
   // 调用对象渲染
-  for (const auto &obj : m_objs) {
-    obj->render();
+  auto count = static_cast<uint32_t>(m_objs.size());
+  auto &pool = context.getThreadPool();
+  uint32_t segments = 1;
+  m_segments.resize(pool.size() + 1);
+  if (count >= kParallelThreshold) {
+    // 剔除、排序键和实例数据按对象范围分给工作线程，每个线程只写自己的段
+    segments = pool.parallelFor(
+        count, kParallelGrain, [&](uint32_t seg, uint32_t begin, uint32_t end) {
+          buildSegment(view, begin, end, m_segments[seg]);
+        });
+  } else {
+    buildSegment(view, 0, count, m_segments[0]);
+  }
+  submitSegments(renderer, segments);
+  submitSegments(renderer, buildWorldSegments(context, view));
+}
+
+uint32_t Scene::buildWorldSegments(engine::core::Context &context,
+                                   const engine::render::AABB &view) {
+  TRIAL_PROFILE_ZONE("Scene::buildWorldSegments");
+  using engine::object::Sprite;
+  using engine::object::Transform;
+  m_world.collectChunks<Transform, Sprite>(m_chunks);
+  if (m_chunks.empty()) {
+    return 0;
+  }
+  const auto &renderer = context.getRenderer();
+  const auto &resources = context.getResource();
+  auto build = [&](uint32_t seg, uint32_t begin, uint32_t end) {
+    m_segments[seg].clear();
+    for (uint32_t i = begin; i < end; i++) {
+      engine::object::buildSprites(*m_chunks[i], view, renderer, resources,
+                                   m_segments[seg]);
+    }
+  };
+  auto chunks = static_cast<uint32_t>(m_chunks.size());
+  // 除了最后一块都是满的，用第一块估计实体数
+  uint32_t per_chunk = std::max(m_chunks[0]->size(), 1u);
+  if (chunks * per_chunk < kParallelThreshold) {
+    build(0, 0, chunks);
+    return 1;
+  }
+  return context.getThreadPool().parallelFor(
+      chunks, std::max(kParallelGrain / per_chunk, 1u), build);
+}
+
+void Scene::submitSegments(engine::render::Renderer &renderer,
+                           uint32_t segments) {
+  // 在持有command buffer的线程上按段号顺序合并
+  uint32_t visible = 0;
+  uint32_t culled = 0;
+  for (uint32_t i = 0; i < segments; i++) {
+    renderer.submitSegment(m_segments[i]);
+    visible += m_segments[i].visible;
+    culled += m_segments[i].culled;
   }
+  renderer.addCullStats(visible, culled);
 }
 
 void Scene::event(engine::core::Context &context [[maybe_unused]]) {}
@@ -1,8 +1,14 @@
 #pragma once
 
 #include "../object/object.hpp"
+#include "../object/world.hpp"
+#include "../renderer/sprite_batch.hpp"
+#include "../renderer/tilemap.hpp"
+#include "../resource_manager/handle.hpp"
 #include <memory>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace engine::core {
@@ -11,37 +17,131 @@ class Context;
 
 namespace engine::scene {
 class Scene {
+public:
+  // 删除对象时剩余对象的排列方式
+  enum class RemovePolicy {
+    // 保持加入顺序
+    Stable,
+    // 用末尾的对象填补空位，移动更少，顺序会改变
+    SwapPop,
+  };
+
 protected:
   std::string m_name;
-  std::vector<std::unique_ptr<engine::object::Object>> m_objs;
-  std::vector<std::unique_ptr<engine::object::Object>> m_pending;
+  // 放在对象列表之前，最后析构
+  engine::core::Pool<engine::object::Object> m_object_pool;
+  std::vector<engine::object::ObjectPtr> m_objs;
+  std::vector<engine::object::ObjectPtr> m_pending;
+  // 名字和标签到对象的索引，对象进入m_objs时加入，删除时移除
+  using ObjIndex = std::unordered_map<engine::core::StringId,
+                                      std::vector<engine::object::Object *>,
+                                      engine::core::StringIdHash>;
+  ObjIndex m_name_index;
+  ObjIndex m_tag_index;
+  // 句柄到对象的槽位，addObj时分配，对象删除时释放
+  engine::resource::SlotMap<engine::object::Object *, engine::object::ObjectTag>
+      m_handles;
+  RemovePolicy m_remove_policy{RemovePolicy::Stable};
+  // 静态瓦片地图层，在对象之前提交
+  std::vector<std::unique_ptr<engine::render::Tilemap>> m_tilemaps;
+  // 按原型分块存储的实体，由场景驱动系统更新和绘制
+  engine::object::World m_world;
+  // update中记录的结构变化，所有系统执行完后统一应用
+  engine::object::CommandBuffer m_commands;
+  // 每个线程一个，跨帧复用避免重新分配
+  std::vector<engine::render::SpriteSegment> m_segments;
+  std::vector<engine::object::Chunk *> m_chunks;
   bool m_init{false};
 
+private:
+  // 对象数量达到这个值才分给工作线程
+  static constexpr uint32_t kParallelThreshold = 4096;
+  // 每个段至少处理的对象数
+  static constexpr uint32_t kParallelGrain = 2048;
+
 private:
   void processPending();
+  void index(engine::object::Object *);
+  void unindex(engine::object::Object *);
+  // 每帧一次遍历移除标记删除的对象和空项，剩下的对象记录插值起点
+  void compactObjs();
+  // 从索引中移除并释放句柄，之后对象可以销毁
+  void release(engine::object::Object *);
+  // 已经进入m_objs，在索引中
+  bool isIndexed(engine::object::Object *) const;
+  // 剔除并提交[begin, end)的对象到segment
+  void buildSegment(const engine::render::AABB &view, uint32_t begin,
+                    uint32_t end, engine::render::SpriteSegment &segment);
+  // 提交实体中的精灵，返回使用的段数
+  uint32_t buildWorldSegments(engine::core::Context &,
+                              const engine::render::AABB &view);
+  // 按段号顺序合并到渲染器
+  void submitSegments(engine::render::Renderer &, uint32_t segments);
 
 public:
   Scene(std::string_view name) : m_name{name} {}
   virtual ~Scene() = default;
 
-  const std::vector<std::unique_ptr<engine::object::Object>> &getObjs() const {
+  const std::vector<engine::object::ObjectPtr> &getObjs() const {
     return m_objs;
   }
 
-  void addObj(std::unique_ptr<engine::object::Object> &&);
+  // 从场景的对象池分配，之后用addObj加入场景
+  template <typename... Args>
+  engine::object::ObjectPtr makeObj(Args &&...args) {
+    return m_object_pool.make(std::forward<Args>(args)...);
+  }
+  // 场景的对象池统计，tile由渲染器的池分配
+  const engine::core::PoolStats &getObjPoolStats() const {
+    return m_object_pool.getStats();
+  }
+
+  engine::object::World &getWorld() { return m_world; }
+  engine::object::CommandBuffer &getCommands() { return m_commands; }
+
+  // 返回对象的句柄，对象为空时返回空句柄
+  engine::object::ObjectHandle addObj(engine::object::ObjectPtr &&);
+  void addTilemap(std::unique_ptr<engine::render::Tilemap> &&);
+  // 加载Tiled地图的所有瓦片层
+  bool loadTiledMap(engine::core::Context &, std::string_view);
   void removeObj(engine::object::Object *);
-  void removeObjByName(const std::string &);
+  void removeObj(engine::object::ObjectHandle);
+  // 字面量在编译期转换成id，运行时的名字用StringId::intern()
+  void removeObjByName(engine::core::StringId);
+
+  // 对象已经删除时返回空，跨帧保存对象时保存句柄而不是指针
+  engine::object::Object *getObj(engine::object::ObjectHandle) const;
+  // 同名时返回最早加入的对象，指针在下一次update前有效
+  engine::object::Object *getObjByName(engine::core::StringId) const;
+  // 还在等待加入的对象找不到
+  engine::object::ObjectHandle findObj(engine::core::StringId) const;
+  // 带有该标签的所有对象，顺序不固定，增删对象后失效
+  const std::vector<engine::object::Object *> &
+  getObjsByTag(engine::core::StringId) const;
+  // 修改已加入场景的对象，同时更新索引
+  void renameObj(engine::object::Object *, const std::string &);
+  void tagObj(engine::object::Object *, engine::core::StringId);
+  void untagObj(engine::object::Object *, engine::core::StringId);
 
-  engine::object::Object *getObjByName(const std::string &) const;
+  void setRemovePolicy(RemovePolicy policy) { m_remove_policy = policy; }
+  RemovePolicy getRemovePolicy() const { return m_remove_policy; }
 
   virtual void init(engine::core::Context &);
   virtual void update(float, engine::core::Context &);
   virtual void render(engine::core::Context &);
+  // 每帧调用一次，本帧的输入从getInput().getSnapshot()读取
   virtual void event(engine::core::Context &);
 
   void clean() {
     if (!m_objs.empty())
       m_objs.clear();
+    m_pending.clear();
+    m_handles.clear();
+    m_name_index.clear();
+    m_tag_index.clear();
+    m_commands.clear();
+    m_world.clear();
+    m_tilemaps.clear();
     m_init = false;
   }
 
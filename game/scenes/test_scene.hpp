@@ -5,6 +5,9 @@
 namespace game {
 
 class TestScene final : public engine::scene::Scene {
+private:
+  engine::object::ObjectHandle m_aa;
+
 public:
   using engine::scene::Scene::Scene;
   ~TestScene() override = default;
@@ -1,19 +1,74 @@
 #include "engine/core/app.hpp"
 #include "game/scenes/test_scene.hpp"
+#include "spdlog/spdlog.h"
 #include <SDL3/SDL_init.h>
 #include <algorithm>
+#include <cstdlib>
 #include <memory>
+#include <string_view>
 #define SDL_MAIN_USE_CALLBACKS 1 /* use the callbacks instead of main() */
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
 std::unique_ptr<engine::core::App> app;
 
-SDL_AppResult SDL_AppInit(void **appstate [[maybe_unused]],
-                          int argc [[maybe_unused]],
-                          char **argv [[maybe_unused]]) {
+// --headless <帧数> 无窗口渲染指定帧数后退出
+// --capture <路径> 无窗口模式下把最后一帧保存为bmp
+// --profile <帧数> 记录性能区间，--trace <路径> 指定输出的chrome trace文件
+// --pack <路径> 从asset_cooker生成的资源包加载资源
+// --bindings <路径> 按键绑定文件
+// --record <路径> 录制输入，--replay <路径> 回放录制的输入
+// --timings <路径> 每帧的cpu耗时写成csv
+static bool parseArgs(int argc, char **argv, engine::core::AppConfig &config) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    if (arg == "--headless" && i + 1 < argc) {
+      config.headless_frames =
+          static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+      if (config.headless_frames == 0) {
+        spdlog::error("--headless需要大于0的帧数");
+        return false;
+      }
+    } else if (arg == "--capture" && i + 1 < argc) {
+      config.capture_path = argv[++i];
+    } else if (arg == "--profile" && i + 1 < argc) {
+      config.profile_frames =
+          static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else if (arg == "--trace" && i + 1 < argc) {
+      config.profile_path = argv[++i];
+    } else if (arg == "--pack" && i + 1 < argc) {
+      config.pack_path = argv[++i];
+    } else if (arg == "--record" && i + 1 < argc) {
+      config.record_path = argv[++i];
+    } else if (arg == "--replay" && i + 1 < argc) {
+      config.replay_path = argv[++i];
+    } else if (arg == "--timings" && i + 1 < argc) {
+      config.timings_path = argv[++i];
+    } else if (arg == "--bindings" && i + 1 < argc) {
+      config.bindings_path = argv[++i];
+    } else if (arg == "--texture-budget" && i + 1 < argc) {
+      config.texture_budget_mb =
+          static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    } else {
+      spdlog::error("未知参数{}，用法: trial [--headless 帧数] [--capture 路径] "
+                    "[--profile 帧数] [--trace 路径] [--pack 路径] "
+                    "[--texture-budget MB] [--bindings 路径] "
+                    "[--record 路径] [--replay 路径] [--timings 路径]",
+                    arg);
+      return false;
+    }
+  }
+  return true;
+}
+
+SDL_AppResult SDL_AppInit(void **appstate [[maybe_unused]], int argc,
+                          char **argv) {
+  engine::core::AppConfig config;
+  if (!parseArgs(argc, argv, config)) {
+    return SDL_APP_FAILURE;
+  }
   app = std::make_unique<engine::core::App>();
-  if (!app->init()) {
+  if (!app->init(config)) {
     return SDL_APP_FAILURE;
   }
   auto scene = std::make_unique<game::TestScene>("test scene");
@@ -31,6 +86,9 @@ SDL_AppResult SDL_AppEvent(void *appstate [[maybe_unused]], SDL_Event *event) {
 SDL_AppResult SDL_AppIterate(void *appstate [[maybe_unused]]) {
   app->update();
   app->render();
+  if (app->finished()) {
+    return SDL_APP_SUCCESS;
+  }
   return SDL_APP_CONTINUE;
 }
 
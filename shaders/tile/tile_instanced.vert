@@ -0,0 +1,30 @@
+#version 450
+
+// 与engine::render::TileInfo保持一致(std430)
+struct TileInfo {
+  vec2 pos;
+  vec2 size;
+  vec4 uv; // 图集中的子区域
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer TileInstances {
+  TileInfo tiles[];
+} instances;
+
+layout(set = 1, binding = 0) uniform RenderInfo{
+  mat4 view_proj; // 相机的view-projection
+} rinfo;
+
+layout(location = 0) in vec2 vertex_pos;
+layout(location = 1) in vec2 texture_coord;
+
+layout(location = 0) out vec2 frag_uv;
+
+void main(){
+  // gl_InstanceIndex包含first_instance，每个贴图批次从自己的偏移开始读
+  TileInfo tinfo = instances.tiles[gl_InstanceIndex];
+  // 顶点在[-1, 1]，pos是tile中心的世界坐标
+  vec2 world = tinfo.pos + vertex_pos * tinfo.size * 0.5;
+  gl_Position = rinfo.view_proj * vec4(world, 0.0, 1.0);
+  frag_uv = tinfo.uv.xy + texture_coord * tinfo.uv.zw;
+}
@@ -0,0 +1,228 @@
+// 离线资源打包工具
+// 用法: asset_cooker [--lz4] <输出文件> <文件或目录>...
+// 条目按命令行中的路径保存，需要在运行游戏的工作目录下打包
+// 图片预先解码成RGBA8，其他文件原样保存
+#include "../engine/resource_manager/asset_pack.hpp"
+#include "SDL3/SDL.h"
+#include "SDL3_image/SDL_image.h"
+#include "spdlog/spdlog.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef TRIAL_HAS_LZ4
+#include <lz4.h>
+#endif
+
+namespace {
+
+using engine::resource::PackEntry;
+using engine::resource::PackHeader;
+using engine::resource::PackType;
+
+struct Item {
+  std::string name;
+  PackEntry entry;
+  std::vector<uint8_t> data;
+};
+
+bool isImage(const std::filesystem::path &path) {
+  auto ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".bmp" ||
+         ext == ".tga";
+}
+
+bool cookTexture(const std::string &file, Item &item) {
+  SDL_Surface *surface = IMG_Load(file.c_str());
+  if (!surface) {
+    spdlog::error("加载图片{}失败{}", file, SDL_GetError());
+    return false;
+  }
+  SDL_Surface *rgba = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_ABGR8888);
+  SDL_DestroySurface(surface);
+  if (!rgba) {
+    spdlog::error("转换图片{}失败{}", file, SDL_GetError());
+    return false;
+  }
+  auto w = static_cast<uint32_t>(rgba->w);
+  auto h = static_cast<uint32_t>(rgba->h);
+  // 去掉行间填充，和gpu上传的布局一致
+  item.data.resize(size_t{w} * h * 4);
+  for (uint32_t y = 0; y < h; y++) {
+    std::memcpy(item.data.data() + size_t{y} * w * 4,
+                static_cast<const uint8_t *>(rgba->pixels) +
+                    size_t{y} * static_cast<size_t>(rgba->pitch),
+                size_t{w} * 4);
+  }
+  SDL_DestroySurface(rgba);
+  item.entry.type = PackType::Texture;
+  item.entry.width = w;
+  item.entry.height = h;
+  return true;
+}
+
+bool cookRaw(const std::string &file, Item &item) {
+  size_t size = 0;
+  void *data = SDL_LoadFile(file.c_str(), &size);
+  if (!data) {
+    spdlog::error("读取文件{}失败{}", file, SDL_GetError());
+    return false;
+  }
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  item.data.assign(bytes, bytes + size);
+  SDL_free(data);
+  item.entry.type = PackType::Raw;
+  return true;
+}
+
+// 压缩后更小时才使用压缩数据
+void compress(Item &item) {
+#ifdef TRIAL_HAS_LZ4
+  int bound = LZ4_compressBound(static_cast<int>(item.data.size()));
+  std::vector<uint8_t> out(static_cast<size_t>(bound));
+  int size = LZ4_compress_default(
+      reinterpret_cast<const char *>(item.data.data()),
+      reinterpret_cast<char *>(out.data()),
+      static_cast<int>(item.data.size()), bound);
+  if (size > 0 && static_cast<size_t>(size) < item.data.size()) {
+    out.resize(static_cast<size_t>(size));
+    item.data = std::move(out);
+    item.entry.flags |= engine::resource::kPackLz4;
+  }
+#else
+  (void)item;
+#endif
+}
+
+void pad(std::ofstream &out, uint64_t &offset, uint64_t align) {
+  static constexpr char kZeros[engine::resource::kPackAlign]{};
+  uint64_t padding = (align - offset % align) % align;
+  out.write(kZeros, static_cast<std::streamsize>(padding));
+  offset += padding;
+}
+
+bool collect(const std::string &arg, std::vector<std::string> &files) {
+  std::error_code ec;
+  if (std::filesystem::is_directory(arg, ec)) {
+    for (const auto &it :
+         std::filesystem::recursive_directory_iterator{arg, ec}) {
+      if (it.is_regular_file()) {
+        files.push_back(it.path().generic_string());
+      }
+    }
+  } else if (std::filesystem::is_regular_file(arg, ec)) {
+    files.push_back(arg);
+  } else {
+    spdlog::error("找不到{}", arg);
+    return false;
+  }
+  return !ec;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bool lz4 = false;
+  std::string output;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    if (arg == "--lz4") {
+      lz4 = true;
+    } else if (output.empty()) {
+      output = arg;
+    } else if (!collect(std::string{arg}, files)) {
+      return 1;
+    }
+  }
+  if (output.empty() || files.empty()) {
+    spdlog::error("用法: asset_cooker [--lz4] <输出文件> <文件或目录>...");
+    return 1;
+  }
+#ifndef TRIAL_HAS_LZ4
+  if (lz4) {
+    spdlog::warn("编译时没有LZ4，不压缩");
+    lz4 = false;
+  }
+#endif
+
+  std::vector<Item> items;
+  for (const auto &file : files) {
+    Item item{};
+    item.name = engine::resource::packNormalize(file);
+    item.entry.hash = engine::resource::packHash(item.name);
+    bool ok = isImage(file) ? cookTexture(file, item) : cookRaw(file, item);
+    if (!ok) {
+      return 1;
+    }
+    item.entry.raw_size = static_cast<uint32_t>(item.data.size());
+    if (lz4) {
+      compress(item);
+    }
+    item.entry.size = static_cast<uint32_t>(item.data.size());
+    items.push_back(std::move(item));
+  }
+  std::sort(items.begin(), items.end(), [](const Item &a, const Item &b) {
+    return a.entry.hash < b.entry.hash;
+  });
+  for (size_t i = 1; i < items.size(); i++) {
+    if (items[i].name == items[i - 1].name) {
+      spdlog::error("重复的条目{}", items[i].name);
+      return 1;
+    }
+  }
+
+  std::ofstream out{output, std::ios::binary};
+  if (!out) {
+    spdlog::error("打开输出文件{}失败", output);
+    return 1;
+  }
+  // 头部最后回写
+  PackHeader header{
+      .magic = engine::resource::kPackMagic,
+      .version = engine::resource::kPackVersion,
+      .count = static_cast<uint32_t>(items.size()),
+      .flags = 0,
+      .index_offset = 0,
+  };
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  uint64_t offset = sizeof(header);
+  for (auto &item : items) {
+    pad(out, offset, engine::resource::kPackAlign);
+    item.entry.offset = offset;
+    out.write(reinterpret_cast<const char *>(item.data.data()),
+              static_cast<std::streamsize>(item.data.size()));
+    offset += item.data.size();
+  }
+  pad(out, offset, engine::resource::kPackAlign);
+  header.index_offset = offset;
+  uint64_t name_offset = offset + items.size() * sizeof(PackEntry);
+  for (auto &item : items) {
+    item.entry.name_offset = static_cast<uint32_t>(name_offset);
+    item.entry.name_size = static_cast<uint32_t>(item.name.size());
+    name_offset += item.name.size();
+    out.write(reinterpret_cast<const char *>(&item.entry), sizeof(PackEntry));
+  }
+  uint64_t raw_total = 0;
+  for (const auto &item : items) {
+    out.write(item.name.data(), static_cast<std::streamsize>(item.name.size()));
+    raw_total += item.entry.raw_size;
+  }
+  out.seekp(0);
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  if (!out) {
+    spdlog::error("写入{}失败", output);
+    return 1;
+  }
+  spdlog::info("打包{}个条目到{}，原始{}字节，包大小{}字节", items.size(),
+               output, raw_total, name_offset);
+  return 0;
+}